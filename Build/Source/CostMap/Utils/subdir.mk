@@ -6,20 +6,33 @@
 CPP_SRCS += \
 ../Source/CostMap/Utils/ArrayParser.cpp \
 ../Source/CostMap/Utils/Footprint.cpp \
-../Source/CostMap/Utils/Math.cpp 
+../Source/CostMap/Utils/Math.cpp \
+../Source/CostMap/Utils/RowKernels.cpp \
+../Source/CostMap/Utils/TransformCache.cpp 
 
 OBJS += \
 ./Source/CostMap/Utils/ArrayParser.o \
 ./Source/CostMap/Utils/Footprint.o \
-./Source/CostMap/Utils/Math.o 
+./Source/CostMap/Utils/Math.o \
+./Source/CostMap/Utils/RowKernels.o \
+./Source/CostMap/Utils/TransformCache.o 
 
 CPP_DEPS += \
 ./Source/CostMap/Utils/ArrayParser.d \
 ./Source/CostMap/Utils/Footprint.d \
-./Source/CostMap/Utils/Math.d 
+./Source/CostMap/Utils/Math.d \
+./Source/CostMap/Utils/RowKernels.d \
+./Source/CostMap/Utils/TransformCache.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
+Source/CostMap/Utils/RowKernels.o: ../Source/CostMap/Utils/RowKernels.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	arm-openwrt-linux-muslgnueabi-g++ -I$(SENAVICOMMON_PATH)/Source -O0 -g3 -Wall -c -fmessage-length=0 -mfpu=neon -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
 Source/CostMap/Utils/%.o: ../Source/CostMap/Utils/%.cpp
 	@echo 'Building file: $<'
 	@echo 'Invoking: Cross G++ Compiler'
@@ -6,26 +6,44 @@
 CPP_SRCS += \
 ../Source/Planner/Implements/GlobalPlanner/Algorithm/Astar.cpp \
 ../Source/Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/FieldCache.cpp \
 ../Source/Planner/Implements/GlobalPlanner/Algorithm/GradientPath.cpp \
 ../Source/Planner/Implements/GlobalPlanner/Algorithm/GridPath.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/Incremental.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/JumpPoint.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/Landmarks.cpp \
 ../Source/Planner/Implements/GlobalPlanner/Algorithm/OrientationFilter.cpp \
-../Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.cpp 
+../Source/Planner/Implements/GlobalPlanner/Algorithm/PlannerWorkspace.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.cpp \
+../Source/Planner/Implements/GlobalPlanner/Algorithm/ThetaStar.cpp 
 
 OBJS += \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/Astar.o \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/FieldCache.o \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/GradientPath.o \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/GridPath.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/Incremental.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/JumpPoint.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/Landmarks.o \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/OrientationFilter.o \
-./Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.o 
+./Source/Planner/Implements/GlobalPlanner/Algorithm/PlannerWorkspace.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.o \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/ThetaStar.o 
 
 CPP_DEPS += \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/Astar.d \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/FieldCache.d \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/GradientPath.d \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/GridPath.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/Incremental.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/JumpPoint.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/Landmarks.d \
 ./Source/Planner/Implements/GlobalPlanner/Algorithm/OrientationFilter.d \
-./Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.d 
+./Source/Planner/Implements/GlobalPlanner/Algorithm/PlannerWorkspace.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.d \
+./Source/Planner/Implements/GlobalPlanner/Algorithm/ThetaStar.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -0,0 +1,27 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../Source/Planner/Implements/HierarchicalPlanner/ClusterGraph.cpp \
+../Source/Planner/Implements/HierarchicalPlanner/HierarchicalPlanner.cpp 
+
+OBJS += \
+./Source/Planner/Implements/HierarchicalPlanner/ClusterGraph.o \
+./Source/Planner/Implements/HierarchicalPlanner/HierarchicalPlanner.o 
+
+CPP_DEPS += \
+./Source/Planner/Implements/HierarchicalPlanner/ClusterGraph.d \
+./Source/Planner/Implements/HierarchicalPlanner/HierarchicalPlanner.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+Source/Planner/Implements/HierarchicalPlanner/%.o: ../Source/Planner/Implements/HierarchicalPlanner/%.cpp
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	arm-openwrt-linux-muslgnueabi-g++ -I$(SENAVICOMMON_PATH)/Source -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
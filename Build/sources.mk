@@ -32,6 +32,7 @@ Source/Planner/Implements/DwaLocalPlanner/Algorithm \
 Source/Planner/Implements/DwaLocalPlanner \
 Source/Planner/Implements/GlobalPlanner/Algorithm \
 Source/Planner/Implements/GlobalPlanner \
+Source/Planner/Implements/HierarchicalPlanner \
 Source/Planner/Implements/TrajectoryLocalPlanner/Algorithm \
 Source/Planner/Implements/TrajectoryLocalPlanner \
 
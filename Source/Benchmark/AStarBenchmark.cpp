@@ -0,0 +1,145 @@
+/*
+ * AStarBenchmark.cpp
+ *
+ * Times the A* expansion, plain, weighted and with landmark tables of the
+ * map, against the Dijkstra expansion on office and open maps, 1000, 2000
+ * and 4000 cells a side unless other sizes are given. Every search runs
+ * corner to corner, and the potential each finds at the goal is printed
+ * with its time and expansion statistics, as a ratio to the one Dijkstra
+ * finds. The landmark tables are built with the planner's default
+ * landmark parameters, their build is not timed with the search.
+ */
+
+#include "PlannerBenchmark.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Astar.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Landmarks.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.h"
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace NS_Planner;
+
+/**
+ * @brief Best time of runs searches, the potentials of the last are left in potential
+ */
+static double timeSearch(Expander& expander,
+                         std::vector< unsigned char >& costs,
+                         unsigned int size, int start, int goal,
+                         float* potential, int runs, bool& found)
+{
+  double best = -1;
+  for(int run = 0; run < runs; run++)
+  {
+    double begin = wallTime();
+    found = expander.calculatePotentials(&costs[0], start % size + 0.5,
+                                         start / size + 0.5, goal % size + 0.5,
+                                         goal / size + 0.5, size * size * 2,
+                                         potential);
+    double elapsed = wallTime() - begin;
+    if(best < 0 || elapsed < best)
+      best = elapsed;
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector< unsigned int > sizes;
+  int runs = 3;
+  float weight = 1.5;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+      weight = atof(argv[++i]);
+    else
+      sizes.push_back(atoi(argv[i]));
+  }
+  if(sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(2000);
+    sizes.push_back(4000);
+  }
+
+  printf("corner to corner searches, best of %d runs, weighted A* at %.2f\n",
+         runs, weight);
+  printf("size  map     search    found  time(ms)  speedup  visited     max queue  goal potential\n");
+
+  PlannerWorkspace workspace;
+  for(unsigned int s = 0; s < sizes.size(); s++)
+  {
+    unsigned int size = sizes[s];
+    workspace.setSize(size, size);
+    QuadraticCalculator p_calc(size, size);
+    DijkstraExpansion dijkstra(&p_calc, size, size);
+    dijkstra.setWorkspace(&workspace);
+    dijkstra.setPreciseStart(true);
+    AStarExpansion astar(&p_calc, size, size);
+    astar.setWorkspace(&workspace);
+    float* potential = workspace.getPotential();
+
+    for(int open = 0; open < 2; open++)
+    {
+      std::vector< unsigned char > costs;
+      if(open)
+      {
+        costs.assign(size * size, NS_CostMap::FREE_SPACE);
+        for(unsigned int i = 0; i < size; i++)
+        {
+          costs[i] = costs[(size - 1) * size + i] = NS_CostMap::LETHAL_OBSTACLE;
+          costs[i * size] = costs[i * size + size - 1] = NS_CostMap::LETHAL_OBSTACLE;
+        }
+      }
+      else
+        makeOfficeCosts(costs, size, 0.05);
+
+      int start = findPassableCell(costs, size, size / 20, size / 20);
+      int goal = findPassableCell(costs, size, size - size / 20,
+                                  size - size / 20);
+      const char* map = open ? "open" : "office";
+
+      bool found = false;
+      double dijkstra_time = timeSearch(dijkstra, costs, size, start, goal,
+                                        potential, runs, found);
+      ExpansionStats stats = dijkstra.getStats();
+      float dijkstra_potential = potential[goal];
+      printf("%-5u %-7s %-9s %-6s %-9.1f %-8.2f %-11lu %-10lu %.0f\n", size,
+             map, "dijkstra", found ? "yes" : "no", dijkstra_time * 1000.0,
+             1.0, stats.cells_visited, stats.max_queue, dijkstra_potential);
+
+      // the tables of the default planner parameters, 8 compact landmarks
+      // in up to 64 MB, built on a copy as the planner builds them
+      LandmarkHeuristic landmarks(new QuadraticCalculator(size, size), 8,
+                                  true, 64UL * 1024 * 1024, "");
+      std::vector< unsigned char > static_costs(costs);
+      landmarks.needsBuild(1);
+      double begin = wallTime();
+      landmarks.build(static_costs, size, size, 1);
+      while(!landmarks.getTable())
+        usleep(1000);
+      double build_time = wallTime() - begin;
+
+      const char* names[] = {"astar", "weighted", "landmarks"};
+      for(int k = 0; k < 3; k++)
+      {
+        astar.setWeight(k == 1 ? weight : 1.0);
+        astar.setLandmarks(k == 2 ? &landmarks : NULL);
+        double elapsed = timeSearch(astar, costs, size, start, goal,
+                                    potential, runs, found);
+        stats = astar.getStats();
+        printf("%-5u %-7s %-9s %-6s %-9.1f %-8.2f %-11lu %-10lu %.0f (%.3f)\n",
+               size, map, names[k], found ? "yes" : "no", elapsed * 1000.0,
+               dijkstra_time / elapsed, stats.cells_visited, stats.max_queue,
+               potential[goal], potential[goal] / dijkstra_potential);
+      }
+      astar.setLandmarks(NULL);
+      printf("%-5u %-7s %d landmarks built in %.1f ms\n", size, map,
+             landmarks.getTable()->getCount(), build_time * 1000.0);
+    }
+  }
+
+  return 0;
+}
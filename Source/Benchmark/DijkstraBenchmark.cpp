@@ -0,0 +1,90 @@
+/*
+ * DijkstraBenchmark.cpp
+ *
+ * Times the Dijkstra expansion of the global planner across square maps,
+ * 2000, 4000 and 8000 cells a side unless other sizes are given. Each size
+ * is searched on an office map and on an open one, corner to corner, and
+ * the expansion statistics are printed with the time.
+ */
+
+#include "PlannerBenchmark.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.h"
+#include <stdio.h>
+
+using namespace NS_Planner;
+
+int main(int argc, char* argv[])
+{
+  std::vector< unsigned int > sizes;
+  int runs = 3;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else
+      sizes.push_back(atoi(argv[i]));
+  }
+  if(sizes.empty())
+  {
+    sizes.push_back(2000);
+    sizes.push_back(4000);
+    sizes.push_back(8000);
+  }
+
+  printf("corner to corner searches, best of %d runs\n", runs);
+  printf("size  map     found  time(ms)  visited     max queue  growths\n");
+
+  PlannerWorkspace workspace;
+  for(unsigned int s = 0; s < sizes.size(); s++)
+  {
+    unsigned int size = sizes[s];
+    workspace.setSize(size, size);
+    QuadraticCalculator p_calc(size, size);
+    DijkstraExpansion dijkstra(&p_calc, size, size);
+    dijkstra.setWorkspace(&workspace);
+    dijkstra.setPreciseStart(true);
+
+    for(int open = 0; open < 2; open++)
+    {
+      std::vector< unsigned char > costs;
+      if(open)
+      {
+        costs.assign(size * size, NS_CostMap::FREE_SPACE);
+        for(unsigned int i = 0; i < size; i++)
+        {
+          costs[i] = costs[(size - 1) * size + i] = NS_CostMap::LETHAL_OBSTACLE;
+          costs[i * size] = costs[i * size + size - 1] = NS_CostMap::LETHAL_OBSTACLE;
+        }
+      }
+      else
+        makeOfficeCosts(costs, size, 0.05);
+
+      int start = findPassableCell(costs, size, size / 20, size / 20);
+      int goal = findPassableCell(costs, size, size - size / 20,
+                                  size - size / 20);
+      double start_x = start % size + 0.5, start_y = start / size + 0.5;
+      double goal_x = goal % size + 0.5, goal_y = goal / size + 0.5;
+
+      double best = -1;
+      bool found = false;
+      for(int run = 0; run < runs; run++)
+      {
+        double begin = wallTime();
+        found = dijkstra.calculatePotentials(&costs[0], start_x, start_y,
+                                             goal_x, goal_y, size * size * 2,
+                                             workspace.getPotential());
+        double elapsed = wallTime() - begin;
+        if(best < 0 || elapsed < best)
+          best = elapsed;
+      }
+
+      ExpansionStats stats = dijkstra.getStats();
+      printf("%-5u %-7s %-6s %-9.1f %-11lu %-10lu %lu\n", size,
+             open ? "open" : "office", found ? "yes" : "no", best * 1000.0,
+             stats.cells_visited, stats.max_queue, stats.queue_growths);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * GoalFieldBenchmark.cpp
+ *
+ * Times plans to one goal taken from a cached goal field, the way the
+ * global planner takes them with field_cache_mb set. The field is
+ * calculated on the costs before any robot cell is cleared, then the robot
+ * moves over inflated cells and the area around it is reported changed
+ * with unchanged costs, as the costmap reports it on every update. Every
+ * such plan must find the field in the cache, the run fails otherwise.
+ */
+
+#include "PlannerBenchmark.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/FieldCache.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/GradientPath.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.h"
+#include <algorithm>
+#include <stdio.h>
+
+using namespace NS_Planner;
+
+int main(int argc, char* argv[])
+{
+  unsigned int size = 2000;
+  int plans = 20;
+  if(argc > 1)
+    size = atoi(argv[1]);
+  if(argc > 2)
+    plans = atoi(argv[2]);
+
+  std::vector< unsigned char > costs;
+  makeOfficeCosts(costs, size, 0.05);
+
+  PlannerWorkspace workspace;
+  workspace.setSize(size, size);
+  QuadraticCalculator p_calc(size, size);
+  DijkstraExpansion dijkstra(&p_calc, size, size);
+  dijkstra.setWorkspace(&workspace);
+  dijkstra.setPreciseStart(true);
+  GradientPath path_maker(&p_calc);
+  path_maker.setWorkspace(&workspace);
+  path_maker.setSize(size, size);
+  path_maker.setLethalCost(253);
+
+  // a field of the whole map fits with room to spare
+  FieldCache cache((unsigned long)size * size * 2 * (sizeof(float) + 1));
+  cache.clear(size, size);
+
+  int goal = findPassableCell(costs, size, size - size / 10, size - size / 10);
+  double goal_x = goal % size, goal_y = goal / size;
+
+  double start = wallTime();
+  float* field = cache.insert(goal, &costs[0]);
+  dijkstra.setExpandAll(true);
+  dijkstra.calculatePotentials(&costs[0], goal_x, goal_y, goal_x, goal_y,
+                               size * size * 2, field);
+  dijkstra.setExpandAll(false);
+  cache.setReached(goal);
+  double field_time = wallTime() - start;
+
+  printf("map %u x %u, field of the goal in %.2f ms\n", size, size,
+         field_time * 1000.0);
+  printf("plan x      y      cost  hit  found  time(ms)\n");
+
+  srand(2);
+  int hits = 0;
+  for(int i = 0; i < plans; i++)
+  {
+    // a robot cell next to an obstacle, the planner clears it
+    int robot = -1;
+    while(robot < 0)
+    {
+      int n = (1 + rand() % (size - 2)) + (1 + rand() % (size - 2)) * size;
+      if(costs[n] > NS_CostMap::FREE_SPACE && costs[n] < NS_CostMap::INSCRIBED_INFLATED_OBSTACLE)
+        robot = n;
+    }
+    int robot_x = robot % size, robot_y = robot / size;
+
+    start = wallTime();
+    int x0 = std::max(robot_x - 20, 0), y0 = std::max(robot_y - 20, 0);
+    cache.markChanged(&costs[0], x0, y0, std::min(robot_x + 21, (int)size),
+                      std::min(robot_y + 21, (int)size));
+    float* potential = cache.find(goal);
+    bool hit = potential != NULL;
+    bool found = false;
+    if(hit)
+    {
+      // the robot cell of the cleared copy, put back after the traceback
+      unsigned char robot_cost = costs[robot];
+      float robot_potential = potential[robot];
+      costs[robot] = NS_CostMap::FREE_SPACE;
+      potential[robot] = POT_HIGH;
+      dijkstra.clearEndpoint(&costs[0], potential, robot_x, robot_y, 0);
+
+      std::vector< std::pair< float, float > > path;
+      found = potential[robot] < POT_HIGH && path_maker.getPath(potential, goal_x, goal_y, robot_x, robot_y, path);
+
+      costs[robot] = robot_cost;
+      potential[robot] = robot_potential;
+      hits++;
+    }
+    double elapsed = wallTime() - start;
+
+    printf("%-4d %-6d %-6d %-5d %-4s %-6s %.3f\n", i, robot_x, robot_y,
+           costs[robot], hit ? "yes" : "NO", found ? "yes" : "no",
+           elapsed * 1000.0);
+  }
+
+  printf("%d of %d plans took the cached field\n", hits, plans);
+  return hits == plans ? 0 : 1;
+}
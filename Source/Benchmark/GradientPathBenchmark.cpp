@@ -0,0 +1,89 @@
+/*
+ * GradientPathBenchmark.cpp
+ *
+ * Times the gradient traceback of a short and of a long path on a large
+ * office map. The traceback is timed alone, with gradients stamped per
+ * path, and after clearing both gradient arrays of the whole map, which is
+ * what every traceback cost before the stamps.
+ */
+
+#include "PlannerBenchmark.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/GradientPath.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.h"
+#include <stdio.h>
+
+using namespace NS_Planner;
+
+int main(int argc, char* argv[])
+{
+  unsigned int size = 4000;
+  int runs = 20;
+  if(argc > 1)
+    size = atoi(argv[1]);
+  if(argc > 2)
+    runs = atoi(argv[2]);
+
+  std::vector< unsigned char > costs;
+  makeOfficeCosts(costs, size, 0.05);
+
+  PlannerWorkspace workspace;
+  workspace.setSize(size, size);
+  QuadraticCalculator p_calc(size, size);
+  DijkstraExpansion dijkstra(&p_calc, size, size);
+  dijkstra.setWorkspace(&workspace);
+  dijkstra.setPreciseStart(true);
+  GradientPath path_maker(&p_calc);
+  path_maker.setWorkspace(&workspace);
+  path_maker.setSize(size, size);
+  path_maker.setLethalCost(253);
+
+  printf("map %u x %u, best of %d runs\n", size, size, runs);
+  printf("path   points  cleared(ms)  stamped(ms)  speedup\n");
+
+  for(int long_path = 0; long_path < 2; long_path++)
+  {
+    // a few cells across a room, or corner to corner
+    unsigned int from = long_path ? size / 20 : size / 2 + 10;
+    unsigned int to = long_path ? size - size / 20 : size / 2 + 30;
+    int start = findPassableCell(costs, size, from, from);
+    int goal = findPassableCell(costs, size, to, to);
+    double start_x = start % size + 0.5, start_y = start / size + 0.5;
+    double goal_x = goal % size + 0.5, goal_y = goal / size + 0.5;
+
+    float* potential = workspace.getPotential();
+    if(!dijkstra.calculatePotentials(&costs[0], start_x, start_y, goal_x,
+                                     goal_y, size * size * 2, potential))
+    {
+      printf("%-6s no path\n", long_path ? "long" : "short");
+      continue;
+    }
+
+    std::vector< std::pair< float, float > > path;
+    double best_cleared = -1, best_stamped = -1;
+    for(int run = 0; run < runs; run++)
+    {
+      path.clear();
+      double begin = wallTime();
+      memset(workspace.getGradX(), 0, size * size * sizeof(float));
+      memset(workspace.getGradY(), 0, size * size * sizeof(float));
+      path_maker.getPath(potential, start_x, start_y, goal_x, goal_y, path);
+      double elapsed = wallTime() - begin;
+      if(best_cleared < 0 || elapsed < best_cleared)
+        best_cleared = elapsed;
+
+      path.clear();
+      begin = wallTime();
+      path_maker.getPath(potential, start_x, start_y, goal_x, goal_y, path);
+      elapsed = wallTime() - begin;
+      if(best_stamped < 0 || elapsed < best_stamped)
+        best_stamped = elapsed;
+    }
+
+    printf("%-6s %-7u %-12.3f %-12.3f %.1f\n", long_path ? "long" : "short",
+           (unsigned int)path.size(), best_cleared * 1000.0,
+           best_stamped * 1000.0, best_cleared / best_stamped);
+  }
+
+  return 0;
+}
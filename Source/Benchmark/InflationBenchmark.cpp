@@ -0,0 +1,119 @@
+/*
+ * InflationBenchmark.cpp
+ *
+ * Times full re-inflation of a costmap by the inflation layer over a range
+ * of inflation radii and resolutions. The checksum of the inflated costs
+ * is printed with every timing, so runs of two builds can be compared.
+ */
+
+#include "../CostMap/CostMap2D/LayeredCostMap.h"
+#include "../CostMap/Layers/InflationLayer.h"
+#include "../CostMap/Utils/Footprint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+using namespace NS_CostMap;
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/**
+ * @brief Walls around the map, a few rooms and scattered obstacle points, the same for every run
+ */
+static void makeObstacles(unsigned char* map, unsigned int size_x,
+                          unsigned int size_y, double resolution)
+{
+  memset(map, FREE_SPACE, size_x * size_y);
+  srand(1);
+
+  unsigned int room = (unsigned int)(5.0 / resolution);
+  for(unsigned int j = 0; j < size_y; j++)
+  {
+    for(unsigned int i = 0; i < size_x; i++)
+    {
+      // doors are left in the room walls
+      bool wall_x = i % room == 0 && (j % room) * 3 / room != 1;
+      bool wall_y = j % room == 0 && (i % room) * 3 / room != 1;
+      if(i == 0 || j == 0 || i == size_x - 1 || j == size_y - 1 || wall_x || wall_y)
+        map[j * size_x + i] = LETHAL_OBSTACLE;
+    }
+  }
+
+  // about one obstacle point per square meter
+  unsigned int points = (unsigned int)(size_x * size_y * resolution * resolution);
+  for(unsigned int k = 0; k < points; k++)
+    map[(rand() % size_y) * size_x + rand() % size_x] = LETHAL_OBSTACLE;
+}
+
+int main(int argc, char* argv[])
+{
+  double size = 10.0; // side of the map in meters
+  int runs = 5;
+  if(argc > 1)
+    size = atof(argv[1]);
+  if(argc > 2)
+    runs = atoi(argv[2]);
+
+  const double radii[] = { 0.5, 1.0, 1.5, 2.0 };
+  const double resolutions[] = { 0.01, 0.02, 0.05 };
+
+  printf("map %.1f m x %.1f m, best of %d runs\n", size, size, runs);
+  printf("radius(m) resolution(m) cells      time(ms)  checksum\n");
+
+  for(unsigned int r = 0; r < sizeof(resolutions) / sizeof(resolutions[0]); r++)
+  {
+    for(unsigned int k = 0; k < sizeof(radii) / sizeof(radii[0]); k++)
+    {
+      LayeredCostmap layered_costmap(true);
+      InflationLayer* inflation = new InflationLayer();
+      layered_costmap.addPlugin(boost::shared_ptr< Layer >(inflation));
+      inflation->initialize(&layered_costmap);
+
+      std::vector< NS_DataType::Point > footprint;
+      makeFootprintFromString(
+          "[[0.16, 0.16], [0.16, -0.16], [-0.16, -0.16], [-0.16, 0.16]]",
+          footprint);
+      layered_costmap.setFootprint(footprint);
+
+      unsigned int cells = (unsigned int)(size / resolutions[r]);
+      layered_costmap.resizeMap(cells, cells, resolutions[r], 0, 0);
+      inflation->setInflationParameters(radii[k], 3.0);
+
+      Costmap2D* master = layered_costmap.getCostmap();
+      unsigned char* map = master->getCharMap();
+      unsigned char* obstacles = new unsigned char[cells * cells];
+      makeObstacles(obstacles, cells, cells, resolutions[r]);
+
+      double best = -1;
+      unsigned long checksum = 0;
+      for(int run = 0; run < runs; run++)
+      {
+        memcpy(map, obstacles, cells * cells);
+        // drops the cached inflation, so every run inflates the whole map
+        inflation->matchSize();
+
+        double start = wallTime();
+        inflation->updateCosts(*master, 0, 0, cells, cells);
+        double elapsed = wallTime() - start;
+        if(best < 0 || elapsed < best)
+          best = elapsed;
+
+        checksum = 0;
+        for(unsigned int i = 0; i < cells * cells; i++)
+          checksum = checksum * 31 + map[i];
+      }
+
+      printf("%-9.2f %-13.2f %-10u %-9.2f %016lx\n", radii[k],
+             resolutions[r], cells * cells, best * 1000.0, checksum);
+      delete[] obstacles;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/*
+ * ParallelDijkstraBenchmark.cpp
+ *
+ * Times the Dijkstra expansion with its blocks split over threads against
+ * the serial expansion, on office maps of 1000 to 8000 cells a side unless
+ * other sizes are given. Each thread count is checked against the serial
+ * potentials, and the threaded results against each other.
+ *
+ * The second table is what the block threshold is set from. It times the
+ * barrier rounds a split block costs and the block update of one cell, and
+ * gives the block size per thread above which splitting saves more than
+ * the rounds cost, were every thread on a core of its own.
+ */
+
+#include "PlannerBenchmark.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/Dijkstra.h"
+#include "../Planner/Implements/GlobalPlanner/Algorithm/QuadraticCalculator.h"
+#include <boost/bind.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/thread/thread.hpp>
+#include <math.h>
+#include <stdio.h>
+
+using namespace NS_Planner;
+
+static const int BARRIER_ROUNDS = 2000;
+static const int BLOCK_ROUNDS = 4; ///< Barrier waits of one split block, its sweeps and the neighbor step
+
+static void waitRounds(boost::barrier* barrier, int rounds)
+{
+  for(int i = 0; i < rounds; i++)
+    barrier->wait();
+}
+
+/**
+ * @brief Seconds a split block spends at the barrier with threads threads
+ */
+static double blockRoundTime(int threads)
+{
+  boost::barrier barrier(threads);
+  boost::thread_group workers;
+  int rounds = BARRIER_ROUNDS * BLOCK_ROUNDS;
+  for(int i = 1; i < threads; i++)
+    workers.create_thread(boost::bind(&waitRounds, &barrier, rounds));
+
+  double start = wallTime();
+  waitRounds(&barrier, rounds);
+  double elapsed = wallTime() - start;
+  workers.join_all();
+  return elapsed / BARRIER_ROUNDS;
+}
+
+/**
+ * @brief Best time of runs searches, the potentials of the last are left in potential
+ */
+static double timeSearch(DijkstraExpansion& dijkstra,
+                         std::vector< unsigned char >& costs,
+                         unsigned int size, int start, int goal,
+                         float* potential, int runs)
+{
+  double best = -1;
+  for(int run = 0; run < runs; run++)
+  {
+    double begin = wallTime();
+    dijkstra.calculatePotentials(&costs[0], start % size + 0.5,
+                                 start / size + 0.5, goal % size + 0.5,
+                                 goal / size + 0.5, size * size * 2,
+                                 potential);
+    double elapsed = wallTime() - begin;
+    if(best < 0 || elapsed < best)
+      best = elapsed;
+  }
+  return best;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector< unsigned int > sizes;
+  std::vector< int > thread_counts;
+  int runs = 1;
+  for(int i = 1; i < argc; i++)
+  {
+    if(strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+      runs = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+      thread_counts.push_back(atoi(argv[++i]));
+    else
+      sizes.push_back(atoi(argv[i]));
+  }
+  if(sizes.empty())
+  {
+    sizes.push_back(1000);
+    sizes.push_back(2000);
+    sizes.push_back(4000);
+    sizes.push_back(8000);
+  }
+  if(thread_counts.empty())
+  {
+    thread_counts.push_back(2);
+    thread_counts.push_back(4);
+  }
+
+  printf("%u cores, corner to corner expand-all searches, best of %d runs\n",
+         boost::thread::hardware_concurrency(), runs);
+  printf("size  threads  time(ms)  speedup  max diff  same as first threaded\n");
+
+  // per thread count, seconds per cell of the block update and seconds
+  // per cell of the serial update, summed over the sizes
+  std::vector< double > block_cell_time(thread_counts.size(), 0);
+  double serial_cell_time = 0;
+
+  PlannerWorkspace workspace;
+  for(unsigned int s = 0; s < sizes.size(); s++)
+  {
+    unsigned int size = sizes[s];
+    std::vector< unsigned char > costs;
+    makeOfficeCosts(costs, size, 0.05);
+    int start = findPassableCell(costs, size, size / 20, size / 20);
+    int goal = findPassableCell(costs, size, size - size / 20,
+                                size - size / 20);
+
+    workspace.setSize(size, size);
+    QuadraticCalculator p_calc(size, size);
+    DijkstraExpansion dijkstra(&p_calc, size, size);
+    dijkstra.setWorkspace(&workspace);
+    dijkstra.setPreciseStart(true);
+    dijkstra.setExpandAll(true);
+    float* potential = workspace.getPotential();
+
+    double serial = timeSearch(dijkstra, costs, size, start, goal, potential,
+                               runs);
+    unsigned long cells = dijkstra.getStats().cells_visited;
+    serial_cell_time += serial / cells;
+    std::vector< float > serial_potential(potential, potential + size * size);
+    std::vector< float > first_potential;
+    printf("%-5u %-8d %-9.1f\n", size, 1, serial * 1000.0);
+
+    for(unsigned int t = 0; t < thread_counts.size(); t++)
+    {
+      dijkstra.setThreads(thread_counts[t]);
+      double elapsed = timeSearch(dijkstra, costs, size, start, goal,
+                                  potential, runs);
+
+      // relative to the serial potential, over the cells both reached
+      double max_diff = 0;
+      for(unsigned int i = 0; i < size * size; i++)
+      {
+        if(potential[i] < POT_HIGH && serial_potential[i] > 0 && serial_potential[i] < POT_HIGH)
+          max_diff = std::max(max_diff, (double)fabs(potential[i] - serial_potential[i]) / serial_potential[i]);
+      }
+
+      bool same = true;
+      if(first_potential.empty())
+        first_potential.assign(potential, potential + size * size);
+      else
+        same = memcmp(&first_potential[0], potential, size * size * sizeof(float)) == 0;
+
+      printf("%-5u %-8d %-9.1f %-8.2f %-9.4f %s\n", size, thread_counts[t],
+             elapsed * 1000.0, serial / elapsed, max_diff,
+             same ? "yes" : "NO");
+
+      // every block on the calling thread, the update alone
+      dijkstra.setParallelBlockCells(size * size);
+      elapsed = timeSearch(dijkstra, costs, size, start, goal, potential,
+                           runs);
+      block_cell_time[t] += elapsed / cells;
+      dijkstra.setParallelBlockCells(DijkstraExpansion::DEFAULT_PARALLEL_BLOCK_CELLS);
+    }
+    dijkstra.setThreads(1);
+  }
+
+  printf("\nthreads  rounds(us)  block update(ns/cell)  serial(ns/cell)  break-even cells per thread\n");
+  for(unsigned int t = 0; t < thread_counts.size(); t++)
+  {
+    int threads = thread_counts[t];
+    if(threads < 2)
+      continue;
+    double rounds = blockRoundTime(threads);
+    double cell = block_cell_time[t] / sizes.size();
+    // a block of n cells per thread takes n * threads * cell alone, and
+    // n * cell + rounds split
+    double break_even = rounds / (cell * (threads - 1));
+    printf("%-8d %-11.1f %-22.1f %-16.1f %.0f\n", threads, rounds * 1e6,
+           cell * 1e9, serial_cell_time / sizes.size() * 1e9, break_even);
+  }
+
+  return 0;
+}
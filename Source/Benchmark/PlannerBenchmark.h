@@ -0,0 +1,98 @@
+/*
+ * PlannerBenchmark.h
+ *
+ * Maps and timing shared by the global planner benchmarks. The costs are
+ * built by the inflation layer, as the global costmap builds them, and
+ * outlined the way the planner outlines its costmap copy.
+ */
+
+#ifndef _PLANNER_BENCHMARK_H_
+#define _PLANNER_BENCHMARK_H_
+
+#include "../CostMap/CostMap2D/LayeredCostMap.h"
+#include "../CostMap/Layers/InflationLayer.h"
+#include "../CostMap/Utils/Footprint.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <vector>
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/**
+ * @brief Costs of a size x size office map, rooms with doors and scattered obstacle points, inflated with the default parameters, the same for every run
+ */
+static void makeOfficeCosts(std::vector< unsigned char >& costs,
+                            unsigned int size, double resolution)
+{
+  NS_CostMap::LayeredCostmap layered_costmap(true);
+  NS_CostMap::InflationLayer* inflation = new NS_CostMap::InflationLayer();
+  layered_costmap.addPlugin(
+      boost::shared_ptr< NS_CostMap::Layer >(inflation));
+  inflation->initialize(&layered_costmap);
+
+  std::vector< NS_DataType::Point > footprint;
+  NS_CostMap::makeFootprintFromString(
+      "[[0.16, 0.16], [0.16, -0.16], [-0.16, -0.16], [-0.16, 0.16]]",
+      footprint);
+  layered_costmap.setFootprint(footprint);
+  layered_costmap.resizeMap(size, size, resolution, 0, 0);
+  inflation->setInflationParameters(1.75, 2.58);
+
+  NS_CostMap::Costmap2D* master = layered_costmap.getCostmap();
+  unsigned char* map = master->getCharMap();
+  memset(map, NS_CostMap::FREE_SPACE, size * size);
+  srand(1);
+
+  // doors are left in the room walls
+  unsigned int room = (unsigned int)(5.0 / resolution);
+  for(unsigned int j = 0; j < size; j++)
+  {
+    for(unsigned int i = 0; i < size; i++)
+    {
+      bool wall_x = i % room == 0 && (j % room) * 3 / room != 1;
+      bool wall_y = j % room == 0 && (i % room) * 3 / room != 1;
+      if(wall_x || wall_y)
+        map[j * size + i] = NS_CostMap::LETHAL_OBSTACLE;
+    }
+  }
+
+  // about one obstacle point per room
+  unsigned int points = (unsigned int)(size * size * resolution * resolution / 25.0);
+  for(unsigned int k = 0; k < points; k++)
+    map[(rand() % size) * size + rand() % size] = NS_CostMap::LETHAL_OBSTACLE;
+
+  inflation->matchSize();
+  inflation->updateCosts(*master, 0, 0, size, size);
+  costs.assign(map, map + size * size);
+
+  // the planner outlines the map, so no search leaves it
+  for(unsigned int i = 0; i < size; i++)
+  {
+    costs[i] = costs[(size - 1) * size + i] = NS_CostMap::LETHAL_OBSTACLE;
+    costs[i * size] = costs[i * size + size - 1] = NS_CostMap::LETHAL_OBSTACLE;
+  }
+}
+
+/**
+ * @brief The passable cell nearest to (x, y) along its row, -1 if the row has none
+ */
+static int findPassableCell(const std::vector< unsigned char >& costs,
+                        unsigned int size, unsigned int x, unsigned int y)
+{
+  for(unsigned int d = 0; d < size; d++)
+  {
+    if(x + d < size && costs[y * size + x + d] < NS_CostMap::INSCRIBED_INFLATED_OBSTACLE)
+      return y * size + x + d;
+    if(x >= d && costs[y * size + x - d] < NS_CostMap::INSCRIBED_INFLATED_OBSTACLE)
+      return y * size + x - d;
+  }
+  return -1;
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * RowKernelBenchmark.cpp
+ *
+ * Times the CostmapLayer combine modes over the whole map and over small
+ * windows, against plain per-cell loops. Each mode also compares its
+ * result with the loop, so a vector path that gives different bytes shows
+ * up here too.
+ */
+
+#include "../CostMap/CostMap2D/CostMapLayer.h"
+#include "../CostMap/Utils/RowKernels.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+using namespace NS_CostMap;
+
+static double wallTime()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+/**
+ * @brief A layer whose combine modes can be called from outside
+ */
+class BenchmarkLayer: public CostmapLayer
+{
+public:
+  BenchmarkLayer()
+  {
+    enabled_ = true;
+  }
+
+  using CostmapLayer::updateWithMax;
+  using CostmapLayer::updateWithOverwrite;
+  using CostmapLayer::updateWithTrueOverwrite;
+  using CostmapLayer::updateWithAddition;
+};
+
+enum CombineMode
+{
+  COMBINE_MAX, COMBINE_OVERWRITE, COMBINE_TRUE_OVERWRITE, COMBINE_ADDITION
+};
+
+static const char* mode_names[] = { "max", "overwrite", "true_overwrite",
+                                    "addition", };
+
+/**
+ * @brief The combine modes as they were written before the row kernels
+ */
+static void combineCells(CombineMode mode, unsigned char* master,
+                         const unsigned char* layer, unsigned int span,
+                         int min_i, int min_j, int max_i, int max_j)
+{
+  for(int j = min_j; j < max_j; j++)
+  {
+    unsigned int it = j * span + min_i;
+    for(int i = min_i; i < max_i; i++, it++)
+    {
+      if(mode == COMBINE_TRUE_OVERWRITE)
+      {
+        master[it] = layer[it];
+        continue;
+      }
+      if(layer[it] == NO_INFORMATION)
+        continue;
+
+      unsigned char old_cost = master[it];
+      if(mode == COMBINE_OVERWRITE || old_cost == NO_INFORMATION)
+        master[it] = layer[it];
+      else if(mode == COMBINE_MAX)
+        master[it] = std::max(old_cost, layer[it]);
+      else
+      {
+        int sum = old_cost + layer[it];
+        if(sum >= INSCRIBED_INFLATED_OBSTACLE)
+          master[it] = INSCRIBED_INFLATED_OBSTACLE - 1;
+        else
+          master[it] = sum;
+      }
+    }
+  }
+}
+
+static void combineRows(CombineMode mode, BenchmarkLayer& layer,
+                        Costmap2D& master, int min_i, int min_j, int max_i,
+                        int max_j)
+{
+  switch(mode)
+  {
+    case COMBINE_MAX:
+      layer.updateWithMax(master, min_i, min_j, max_i, max_j);
+      break;
+    case COMBINE_OVERWRITE:
+      layer.updateWithOverwrite(master, min_i, min_j, max_i, max_j);
+      break;
+    case COMBINE_TRUE_OVERWRITE:
+      layer.updateWithTrueOverwrite(master, min_i, min_j, max_i, max_j);
+      break;
+    case COMBINE_ADDITION:
+      layer.updateWithAddition(master, min_i, min_j, max_i, max_j);
+      break;
+  }
+}
+
+/**
+ * @brief Free, unknown, inflated and lethal cells in random runs
+ */
+static void fillRandom(unsigned char* map, unsigned int cells)
+{
+  const unsigned char values[] = { FREE_SPACE, NO_INFORMATION, 50, 200,
+                                   INSCRIBED_INFLATED_OBSTACLE,
+                                   LETHAL_OBSTACLE, };
+  unsigned int i = 0;
+  while(i < cells)
+  {
+    unsigned char value = values[rand() % 6];
+    for(unsigned int run = 1 + rand() % 16; run > 0 && i < cells; run--)
+      map[i++] = value;
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned int cells = 2000;
+  unsigned int window = 200;
+  int runs = 20;
+  if(argc > 1)
+    cells = atoi(argv[1]);
+  if(argc > 2)
+    window = atoi(argv[2]);
+  if(argc > 3)
+    runs = atoi(argv[3]);
+  if(window > cells)
+    window = cells;
+
+  BenchmarkLayer layer;
+  layer.resizeMap(cells, cells, 0.05, 0, 0);
+  Costmap2D master(cells, cells, 0.05, 0, 0);
+  unsigned char* initial = new unsigned char[cells * cells];
+  unsigned char* expected = new unsigned char[cells * cells];
+
+  srand(1);
+  fillRandom(layer.getCharMap(), cells * cells);
+  fillRandom(initial, cells * cells);
+
+  // the same windows for both paths, starting at odd offsets
+  int windows = 100;
+  int* window_i = new int[windows];
+  int* window_j = new int[windows];
+  for(int w = 0; w < windows; w++)
+  {
+    window_i[w] = rand() % (cells - window + 1);
+    window_j[w] = rand() % (cells - window + 1);
+  }
+
+  printf("row kernels: %s, map %u x %u, %d windows of %u x %u, best of %d runs\n",
+         rowKernelName(), cells, cells, windows, window, window, runs);
+  printf("mode            area    loop(ms)  kernel(ms)  speedup  same\n");
+
+  for(int m = COMBINE_MAX; m <= COMBINE_ADDITION; m++)
+  {
+    CombineMode mode = (CombineMode)m;
+    for(int windowed = 0; windowed < 2; windowed++)
+    {
+      double best_loop = -1, best_kernel = -1;
+      for(int run = 0; run < runs; run++)
+      {
+        memcpy(expected, initial, cells * cells);
+        double start = wallTime();
+        if(windowed)
+        {
+          for(int w = 0; w < windows; w++)
+            combineCells(mode, expected, layer.getCharMap(), cells,
+                         window_i[w], window_j[w], window_i[w] + window,
+                         window_j[w] + window);
+        }
+        else
+          combineCells(mode, expected, layer.getCharMap(), cells, 0, 0,
+                       cells, cells);
+        double elapsed = wallTime() - start;
+        if(best_loop < 0 || elapsed < best_loop)
+          best_loop = elapsed;
+
+        memcpy(master.getCharMap(), initial, cells * cells);
+        start = wallTime();
+        if(windowed)
+        {
+          for(int w = 0; w < windows; w++)
+            combineRows(mode, layer, master, window_i[w], window_j[w],
+                        window_i[w] + window, window_j[w] + window);
+        }
+        else
+          combineRows(mode, layer, master, 0, 0, cells, cells);
+        elapsed = wallTime() - start;
+        if(best_kernel < 0 || elapsed < best_kernel)
+          best_kernel = elapsed;
+      }
+
+      bool same = memcmp(expected, master.getCharMap(), cells * cells) == 0;
+      printf("%-15s %-7s %-9.3f %-11.3f %-8.1f %s\n", mode_names[mode],
+             windowed ? "window" : "full", best_loop * 1000.0,
+             best_kernel * 1000.0, best_loop / best_kernel, same ? "yes" : "NO");
+    }
+  }
+
+  delete[] window_i;
+  delete[] window_j;
+  delete[] expected;
+  delete[] initial;
+  return 0;
+}
@@ -61,6 +61,14 @@ namespace NS_CostMap
   {
     boost::unique_lock< mutex_t > lock(*(access_));
     unsigned int len = xn - x0;
+    // full rows are contiguous, clear them with a single memset
+    if(x0 == 0 && len == size_x_)
+    {
+      if(yn > y0)
+        memset(costmap_ + y0 * size_x_, default_value_,
+               (yn - y0) * size_x_ * sizeof(unsigned char));
+      return;
+    }
     for(unsigned int y = y0 * size_x_ + x0; y < yn * size_x_ + x0; y += size_x_)
       memset(costmap_ + y, default_value_, len * sizeof(unsigned char));
   }
@@ -111,8 +119,15 @@ namespace NS_CostMap
     if(this == &map)
       return *this;
 
-    // clean up old data
-    deleteMaps();
+    // keep the buffer when the size does not change, only copy into it
+    if(costmap_ == NULL || size_x_ != map.size_x_ || size_y_ != map.size_y_)
+    {
+      // clean up old data
+      deleteMaps();
+
+      // initialize our various maps
+      initMaps(map.size_x_, map.size_y_);
+    }
 
     size_x_ = map.size_x_;
     size_y_ = map.size_y_;
@@ -120,9 +135,6 @@ namespace NS_CostMap
     origin_x_ = map.origin_x_;
     origin_y_ = map.origin_y_;
 
-    // initialize our various maps
-    initMaps(size_x_, size_y_);
-
     // copy the cost map
     memcpy(costmap_, map.costmap_, size_x_ * size_y_ * sizeof(unsigned char));
 
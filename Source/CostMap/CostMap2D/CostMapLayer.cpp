@@ -1,4 +1,5 @@
 #include "CostMapLayer.h"
+#include "../Utils/RowKernels.h"
 
 namespace NS_CostMap
 {
@@ -52,26 +53,15 @@ namespace NS_CostMap
   {
     if(!enabled_)
       return;
-
     unsigned char* master_array = master_grid.getCharMap();
     unsigned int span = master_grid.getSizeInCellsX();
+    if(max_i <= min_i)
+      return;
 
     for(int j = min_j; j < max_j; j++)
     {
       unsigned int it = j * span + min_i;
-      for(int i = min_i; i < max_i; i++)
-      {
-        if(costmap_[it] == NO_INFORMATION)
-        {
-          it++;
-          continue;
-        }
-
-        unsigned char old_cost = master_array[it];
-        if(old_cost == NO_INFORMATION || old_cost < costmap_[it])
-          master_array[it] = costmap_[it];
-        it++;
-      }
+      maxRow(master_array + it, costmap_ + it, max_i - min_i);
     }
   }
 
@@ -80,17 +70,15 @@ namespace NS_CostMap
   {
     if(!enabled_)
       return;
-    unsigned char* master = master_grid.getCharMap();
+    unsigned char* master_array = master_grid.getCharMap();
     unsigned int span = master_grid.getSizeInCellsX();
+    if(max_i <= min_i)
+      return;
 
     for(int j = min_j; j < max_j; j++)
     {
-      unsigned int it = span * j + min_i;
-      for(int i = min_i; i < max_i; i++)
-      {
-        master[it] = costmap_[it];
-        it++;
-      }
+      unsigned int it = j * span + min_i;
+      trueOverwriteRow(master_array + it, costmap_ + it, max_i - min_i);
     }
   }
 
@@ -99,18 +87,15 @@ namespace NS_CostMap
   {
     if(!enabled_)
       return;
-    unsigned char* master = master_grid.getCharMap();
+    unsigned char* master_array = master_grid.getCharMap();
     unsigned int span = master_grid.getSizeInCellsX();
+    if(max_i <= min_i)
+      return;
 
     for(int j = min_j; j < max_j; j++)
     {
-      unsigned int it = span * j + min_i;
-      for(int i = min_i; i < max_i; i++)
-      {
-        if(costmap_[it] != NO_INFORMATION)
-          master[it] = costmap_[it];
-        it++;
-      }
+      unsigned int it = j * span + min_i;
+      overwriteRow(master_array + it, costmap_ + it, max_i - min_i);
     }
   }
 
@@ -121,31 +106,13 @@ namespace NS_CostMap
       return;
     unsigned char* master_array = master_grid.getCharMap();
     unsigned int span = master_grid.getSizeInCellsX();
+    if(max_i <= min_i)
+      return;
 
     for(int j = min_j; j < max_j; j++)
     {
       unsigned int it = j * span + min_i;
-      for(int i = min_i; i < max_i; i++)
-      {
-        if(costmap_[it] == NO_INFORMATION)
-        {
-          it++;
-          continue;
-        }
-
-        unsigned char old_cost = master_array[it];
-        if(old_cost == NO_INFORMATION)
-          master_array[it] = costmap_[it];
-        else
-        {
-          int sum = old_cost + costmap_[it];
-          if(sum >= INSCRIBED_INFLATED_OBSTACLE)
-            master_array[it] = INSCRIBED_INFLATED_OBSTACLE - 1;
-          else
-            master_array[it] = sum;
-        }
-        it++;
-      }
+      addRow(master_array + it, costmap_ + it, max_i - min_i);
     }
   }
 }  // namespace costmap_2d
@@ -0,0 +1,105 @@
+#ifndef _COSTMAP_COSTMAP_SNAPSHOT_H_
+#define _COSTMAP_COSTMAP_SNAPSHOT_H_
+
+#include "CostMap2D.h"
+#include <boost/shared_ptr.hpp>
+#include <algorithm>
+
+namespace NS_CostMap
+{
+  /**
+   * @class CostmapSnapshot
+   * @brief An immutable copy of the master costmap published by LayeredCostmap
+   *
+   * Readers keep the snapshot alive through the shared pointer they got, so
+   * they never need the costmap lock while the updater keeps working.
+   */
+  class CostmapSnapshot
+  {
+  public:
+    CostmapSnapshot()
+        : version_(0)
+    {
+    }
+
+    /** @brief The copied costmap, it is never changed after publishing */
+    const Costmap2D& getCostmap() const
+    {
+      return costmap_;
+    }
+
+    /** @brief Increases by one for every published snapshot, 0 means no map yet */
+    unsigned long getVersion() const
+    {
+      return version_;
+    }
+
+  private:
+    friend class LayeredCostmap;
+
+    Costmap2D costmap_;
+    unsigned long version_;
+  };
+
+  typedef boost::shared_ptr< const CostmapSnapshot > CostmapSnapshotPtr;
+
+  /**
+   * @class LockWaitStats
+   * @brief Accumulates how long one side waited for a lock
+   */
+  class LockWaitStats
+  {
+  public:
+    LockWaitStats()
+        : count(0), total_wait(0.0), max_wait(0.0)
+    {
+    }
+
+    void add(double wait)
+    {
+      count++;
+      total_wait += wait;
+      if(wait > max_wait)
+        max_wait = wait;
+    }
+
+    double averageWait() const
+    {
+      return count ? total_wait / count : 0.0;
+    }
+
+    unsigned long count;
+    double total_wait; ///< Seconds
+    double max_wait; ///< Seconds
+  };
+
+  /**
+   * @class DirtyRect
+   * @brief World bounds of the cells rewritten by one costmap update
+   */
+  class DirtyRect
+  {
+  public:
+    DirtyRect(double min_x_, double min_y_, double max_x_, double max_y_)
+        : min_x(min_x_), min_y(min_y_), max_x(max_x_), max_y(max_y_)
+    {
+    }
+
+    bool contains(double x, double y) const
+    {
+      return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+    }
+
+    void merge(const DirtyRect& other)
+    {
+      min_x = std::min(min_x, other.min_x);
+      min_y = std::min(min_y, other.min_y);
+      max_x = std::max(max_x, other.max_x);
+      max_y = std::max(max_y, other.max_y);
+    }
+
+    double min_x, min_y, max_x, max_y;
+  };
+}
+
+#endif  // _COSTMAP_COSTMAP_SNAPSHOT_H_
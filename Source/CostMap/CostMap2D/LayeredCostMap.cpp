@@ -6,14 +6,19 @@
 #include <algorithm>
 #include <vector>
 #include <Console/Console.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 using std::vector;
 
 namespace NS_CostMap
 {
 
-  LayeredCostmap::LayeredCostmap(bool track_unknown)
-      : costmap_(), initialized_(false), size_locked_(false)
+  LayeredCostmap::LayeredCostmap(bool track_unknown, bool rolling_window)
+      : costmap_(), rolling_window_(rolling_window), initialized_(false),
+        size_locked_(false),
+        circumscribed_radius_(0.0), inscribed_radius_(0.0), footprint_hash_(0),
+        footprint_set_(false), snapshot_(new CostmapSnapshot()),
+        snapshot_version_(0), size_changed_(false), history_floor_(0)
   {
     if(track_unknown)
       costmap_.setDefaultValue(255);
@@ -34,7 +39,9 @@ namespace NS_CostMap
                                  double origin_y, bool size_locked)
   {
     size_locked_ = size_locked;
+    boost::unique_lock< Costmap2D::mutex_t > lock(*(costmap_.getMutex()));
     costmap_.resizeMap(size_x, size_y, resolution, origin_x, origin_y);
+    size_changed_ = true;
     for(vector< boost::shared_ptr< Layer > >::iterator plugin = plugins_.begin();
         plugin != plugins_.end(); ++plugin)
     {
@@ -56,7 +63,22 @@ namespace NS_CostMap
 
     // Lock for the remainder of this function, some plugins (e.g. VoxelLayer)
     // implement thread unsafe updateBounds() functions.
+    boost::posix_time::ptime wait_start =
+        boost::posix_time::microsec_clock::universal_time();
     boost::unique_lock< Costmap2D::mutex_t > lock(*(costmap_.getMutex()));
+    double wait = (boost::posix_time::microsec_clock::universal_time() - wait_start).total_microseconds() * 1e-6;
+    {
+      boost::mutex::scoped_lock snapshot_lock(snapshot_lock_);
+      update_wait_.add(wait);
+    }
+
+    if(rolling_window_)
+    {
+      // keep the robot in the centre of the window
+      double new_origin_x = robot_x - costmap_.getSizeInMetersX() / 2;
+      double new_origin_y = robot_y - costmap_.getSizeInMetersY() / 2;
+      costmap_.updateOrigin(new_origin_x, new_origin_y);
+    }
 
     for(vector< boost::shared_ptr< Layer > >::iterator plugin = plugins_.begin();
         plugin != plugins_.end(); ++plugin)
@@ -88,7 +110,11 @@ namespace NS_CostMap
     //printf("Updating area x: [%d, %d] y: [%d, %d]\n", x0, xn, y0, yn);
 
     if(xn < x0 || yn < y0)
+    {
+      if(size_changed_)
+        publishSnapshot();
       return;
+    }
 
     costmap_.resetMap(x0, y0, xn, yn);
     for(vector< boost::shared_ptr< Layer > >::iterator plugin = plugins_.begin();
@@ -97,6 +123,40 @@ namespace NS_CostMap
       (*plugin)->updateCosts(costmap_, x0, y0, xn, yn);
     }
 
+    if(xn > x0 && yn > y0)
+    {
+      double wx0, wy0, wxn, wyn;
+      costmap_.mapToWorld(x0, y0, wx0, wy0);
+      costmap_.mapToWorld(xn - 1, yn - 1, wxn, wyn);
+      double half_cell = costmap_.getResolution() / 2;
+      DirtyRect rect(wx0 - half_cell, wy0 - half_cell, wxn + half_cell,
+                     wyn + half_cell);
+
+      boost::mutex::scoped_lock snapshot_lock(snapshot_lock_);
+
+      // the snapshot published below is the first one with rect
+      change_history_.push_back(std::make_pair(snapshot_version_ + 1, rect));
+      if(change_history_.size() > MAX_CHANGE_HISTORY)
+      {
+        history_floor_ = std::max(history_floor_, change_history_.front().first);
+        change_history_.pop_front();
+      }
+
+      // nobody is taking them, fold them into one rectangle
+      if(dirty_rects_.size() >= 64)
+      {
+        for(unsigned int i = 1; i < dirty_rects_.size(); i++)
+          dirty_rects_[0].merge(dirty_rects_[i]);
+        dirty_rects_.erase(dirty_rects_.begin() + 1, dirty_rects_.end());
+        dirty_rects_[0].merge(rect);
+      }
+      else
+        dirty_rects_.push_back(rect);
+    }
+
+    if((xn > x0 && yn > y0) || size_changed_)
+      publishSnapshot();
+
     bx0_ = x0;
     bxn_ = xn;
     by0_ = y0;
@@ -105,6 +165,63 @@ namespace NS_CostMap
     initialized_ = true;
   }
 
+  void LayeredCostmap::publishSnapshot()
+  {
+    // reuse the previous snapshot when no reader holds it anymore, so
+    // publishing is a copy into a buffer of the same size most of the time
+    boost::shared_ptr< CostmapSnapshot > snapshot;
+    if(spare_snapshot_ && spare_snapshot_.unique())
+      snapshot.swap(spare_snapshot_);
+    else
+      snapshot.reset(new CostmapSnapshot());
+
+    snapshot->costmap_ = costmap_;
+    snapshot->version_ = ++snapshot_version_;
+    // a resized or moved map changes the meaning of every cell
+    bool moved = size_changed_ || rolling_window_;
+    size_changed_ = false;
+
+    boost::mutex::scoped_lock lock(snapshot_lock_);
+    if(moved)
+      history_floor_ = snapshot->version_;
+    spare_snapshot_ = snapshot_;
+    snapshot_ = snapshot;
+  }
+
+  void LayeredCostmap::takeDirtyRects(std::vector< DirtyRect >& rects)
+  {
+    rects.clear();
+    boost::mutex::scoped_lock lock(snapshot_lock_);
+    rects.swap(dirty_rects_);
+  }
+
+  bool LayeredCostmap::getChangesSince(unsigned long version,
+                                       std::vector< DirtyRect >& rects)
+  {
+    rects.clear();
+    boost::mutex::scoped_lock lock(snapshot_lock_);
+    if(version == 0 || version < history_floor_)
+      return false;
+
+    for(std::deque< std::pair< unsigned long, DirtyRect > >::iterator change =
+        change_history_.begin(); change != change_history_.end(); ++change)
+    {
+      if(change->first > version)
+        rects.push_back(change->second);
+    }
+    return true;
+  }
+
+  CostmapSnapshotPtr LayeredCostmap::getSnapshot()
+  {
+    boost::posix_time::ptime wait_start =
+        boost::posix_time::microsec_clock::universal_time();
+    boost::mutex::scoped_lock lock(snapshot_lock_);
+    double wait = (boost::posix_time::microsec_clock::universal_time() - wait_start).total_microseconds() * 1e-6;
+    snapshot_wait_.add(wait);
+    return snapshot_;
+  }
+
   bool LayeredCostmap::isCurrent()
   {
     current_ = true;
@@ -119,9 +236,26 @@ namespace NS_CostMap
   void LayeredCostmap::setFootprint(
       const std::vector< NS_DataType::Point >& footprint_spec)
   {
+    unsigned long hash = hashFootprint(footprint_spec);
+    double inscribed_radius, circumscribed_radius;
+    calculateMinAndMaxDistances(footprint_spec, inscribed_radius,
+                                circumscribed_radius);
+
+    // the wrapper sets the same footprint every cycle, only a real change
+    // should make the layers rebuild their kernels
+    if(footprint_set_ && hash == footprint_hash_ &&
+       footprint_spec.size() == footprint_.size() &&
+       inscribed_radius == inscribed_radius_ &&
+       circumscribed_radius == circumscribed_radius_)
+    {
+      return;
+    }
+
     footprint_ = footprint_spec;
-    calculateMinAndMaxDistances(footprint_spec, inscribed_radius_,
-                                circumscribed_radius_);
+    footprint_hash_ = hash;
+    footprint_set_ = true;
+    inscribed_radius_ = inscribed_radius;
+    circumscribed_radius_ = circumscribed_radius;
 
     for(vector< boost::shared_ptr< Layer > >::iterator plugin = plugins_.begin();
         plugin != plugins_.end(); ++plugin)
@@ -4,7 +4,10 @@
 #include "CostValues.h"
 #include "Layer.h"
 #include "CostMap2D.h"
+#include "CostmapSnapshot.h"
+#include <boost/thread/mutex.hpp>
 #include <vector>
+#include <deque>
 #include <string>
 
 namespace NS_CostMap
@@ -21,7 +24,7 @@ namespace NS_CostMap
     /**
      * @brief  Constructor for a costmap
      */
-    LayeredCostmap(bool track_unknown);
+    LayeredCostmap(bool track_unknown, bool rolling_window = false);
 
     /**
      * @brief  Destructor
@@ -51,12 +54,58 @@ namespace NS_CostMap
     bool
     isCurrent();
 
+    /** @brief True when the master costmap is a window that follows the robot */
+    bool isRolling()
+    {
+      return rolling_window_;
+    }
+
     Costmap2D*
     getCostmap()
     {
       return &costmap_;
     }
 
+    /**
+     * @brief  Get the latest published copy of the master costmap.
+     * Only a short pointer copy is locked, the costmap lock is never taken,
+     * so readers do not wait for a running update.
+     */
+    CostmapSnapshotPtr
+    getSnapshot();
+
+    /**
+     * @brief  Move the rectangles updated since the last call into rects.
+     * Every update that rewrote cells adds one rectangle, so a consumer can
+     * check its own data against only the changed areas.
+     */
+    void
+    takeDirtyRects(std::vector< DirtyRect >& rects);
+
+    /**
+     * @brief  Get the rectangles updated after the snapshot of version was published.
+     * Unlike takeDirtyRects() nothing is consumed, so any number of readers
+     * can follow the changes of their own snapshot.
+     * @return false if the changes are not known any more, or the map was
+     * resized or moved since, then everything has to be treated as changed
+     */
+    bool
+    getChangesSince(unsigned long version, std::vector< DirtyRect >& rects);
+
+    /** @brief How long updateMap() waited for the costmap lock */
+    LockWaitStats getUpdateWaitStats()
+    {
+      boost::mutex::scoped_lock lock(snapshot_lock_);
+      return update_wait_;
+    }
+
+    /** @brief How long getSnapshot() callers waited for the snapshot */
+    LockWaitStats getSnapshotWaitStats()
+    {
+      boost::mutex::scoped_lock lock(snapshot_lock_);
+      return snapshot_wait_;
+    }
+
     bool isTrackingUnknown()
     {
       return costmap_.getDefaultValue() == NS_CostMap::NO_INFORMATION;
@@ -94,7 +143,10 @@ namespace NS_CostMap
 
     /** @brief Updates the stored footprint, updates the circumscribed
      * and inscribed radii, and calls onFootprintChanged() in all
-     * layers. */
+     * layers.
+     *
+     * Nothing is done when the footprint content and radii are the same
+     * as the stored ones, so it is cheap to call every cycle. */
     void
     setFootprint(const std::vector< NS_DataType::Point >& footprint_spec);
 
@@ -105,6 +157,12 @@ namespace NS_CostMap
       return footprint_;
     }
 
+    /** @brief Returns the content hash of the latest footprint stored with setFootprint(). */
+    unsigned long getFootprintHash()
+    {
+      return footprint_hash_;
+    }
+
     /** @brief The radius of a circle centered at the origin of the
      * robot which just surrounds all points on the robot's
      * footprint.
@@ -126,6 +184,13 @@ namespace NS_CostMap
     }
 
   private:
+    /**
+     * @brief  Copy the master costmap into a new snapshot and publish it,
+     * must be called with the costmap lock held.
+     */
+    void
+    publishSnapshot();
+
     Costmap2D costmap_;
 
     bool current_;
@@ -134,10 +199,25 @@ namespace NS_CostMap
 
     std::vector< boost::shared_ptr< Layer > > plugins_;
 
+    bool rolling_window_; ///< Move the origin with the robot on every update
     bool initialized_;
     bool size_locked_;
     double circumscribed_radius_, inscribed_radius_;
     std::vector< NS_DataType::Point > footprint_;
+    unsigned long footprint_hash_;
+    bool footprint_set_; ///< True once setFootprint() has been called
+
+    boost::shared_ptr< CostmapSnapshot > snapshot_; ///< The snapshot handed to readers
+    boost::shared_ptr< CostmapSnapshot > spare_snapshot_; ///< The previous snapshot, reused once no reader holds it
+    unsigned long snapshot_version_;
+    bool size_changed_; ///< A resize must be published even without updated cells
+    boost::mutex snapshot_lock_; ///< Guards the snapshot pointers and the wait statistics
+    LockWaitStats update_wait_, snapshot_wait_;
+    std::vector< DirtyRect > dirty_rects_; ///< Updated areas not taken yet, guarded by snapshot_lock_
+
+    static const unsigned int MAX_CHANGE_HISTORY = 256;
+    std::deque< std::pair< unsigned long, DirtyRect > > change_history_; ///< Updated areas with the first snapshot version that has them, guarded by snapshot_lock_
+    unsigned long history_floor_; ///< Changes after versions below it are not known, guarded by snapshot_lock_
   };
 
 }  // namespace costmap_2d
@@ -14,13 +14,18 @@
 #include <Parameter/Parameter.h>
 #include <Time/Rate.h>
 #include "Utils/Footprint.h"
+#include "Utils/TransformCache.h"
 
 namespace NS_CostMap
 {
 
-  CostmapWrapper::CostmapWrapper()
+  CostmapWrapper::CostmapWrapper(const std::string& config_file,
+                                 bool rolling_window)
+      : config_file_(config_file), rolling_window_(rolling_window)
   {
     layered_costmap = NULL;
+    footprint_hash = 0;
+    footprint_hash_valid = false;
 
     cost_translation_table = NULL;
     if(cost_translation_table == NULL)
@@ -40,12 +45,6 @@ namespace NS_CostMap
         cost_translation_table[i] = char(1 + (97 * (i - 1)) / 251);
       }
     }
-
-    odom_tf_cli = new NS_Service::Client< NS_ServiceType::ServiceTransform >(
-        "BASE_ODOM_TF");
-
-    map_tf_cli = new NS_Service::Client< NS_ServiceType::ServiceTransform >(
-        "ODOM_MAP_TF");
   }
 
   CostmapWrapper::~CostmapWrapper()
@@ -55,10 +54,6 @@ namespace NS_CostMap
 
     if(cost_translation_table)
       delete cost_translation_table;
-
-    delete odom_tf_cli;
-
-    delete map_tf_cli;
   }
 
   void CostmapWrapper::updateMap()
@@ -126,9 +121,21 @@ namespace NS_CostMap
   void CostmapWrapper::updateMapLoop(double frequency)
   {
     NS_NaviCommon::Rate rate(frequency);
+    unsigned long cycles = 0;
     while(running)
     {
       updateMap();
+
+      if(++cycles % 100 == 0)
+      {
+        LockWaitStats update_wait = layered_costmap->getUpdateWaitStats();
+        LockWaitStats snapshot_wait = layered_costmap->getSnapshotWaitStats();
+        NS_NaviCommon::console.debug(
+            "Costmap lock waits, updater: avg %.6fs max %.6fs over %lu, snapshot readers: avg %.6fs max %.6fs over %lu",
+            update_wait.averageWait(), update_wait.max_wait, update_wait.count,
+            snapshot_wait.averageWait(), snapshot_wait.max_wait,
+            snapshot_wait.count);
+      }
       if(layered_costmap->isInitialized())
       {
         unsigned int _x0_, _y0_, _xn_, _yn_;
@@ -143,13 +150,18 @@ namespace NS_CostMap
   void CostmapWrapper::loadParameters()
   {
     NS_NaviCommon::Parameter parameter;
-    parameter.loadConfigurationFile("costmap.xml");
+    parameter.loadConfigurationFile(config_file_.c_str());
 
     if(parameter.getParameter("track_unknown_space", 1) == 1)
       track_unknown_space_ = true;
     else
       track_unknown_space_ = false;
 
+    if(parameter.getParameter("rolling_window", rolling_window_ ? 1 : 0) == 1)
+      rolling_window_ = true;
+    else
+      rolling_window_ = false;
+
     footprint_ = parameter.getParameter(
         "footprint",
         "[[0.16, 0.16], [0.16, -0.16], [-0.16, -0.16], [-0.16, 0.16]]");
@@ -202,44 +214,21 @@ namespace NS_CostMap
   bool CostmapWrapper::getRobotPose(
       NS_Transform::Stamped< NS_Transform::Pose >& global_pose) const
   {
-    NS_ServiceType::ServiceTransform odom_transform;
-    NS_ServiceType::ServiceTransform map_transform;
-
-    if(odom_tf_cli->call(odom_transform) == false)
-    {
-      //printf("Get odometry transform failure!\n");
-      return false;
-    }
-
-    if(odom_transform.result == false)
-    {
-      return false;
-    }
-
-    if(map_tf_cli->call(map_transform) == false)
-    {
-      //printf("Get map transform failure!\n");
-      return false;
-    }
-
-    if(map_transform.result == false)
-    {
-      return false;
-    }
-
-    //TODO: not verify code for transform
-    NS_Transform::Transform odom_tf, map_tf;
-    NS_Transform::transformMsgToTF(odom_transform.transform, odom_tf);
-    NS_Transform::transformMsgToTF(map_transform.transform, map_tf);
-
-    global_pose.setData(odom_tf * map_tf);
-
-    return true;
+    // answered from the newest samples of the shared cache, the transform
+    // services are polled by its own thread instead of on every call
+    return TransformCache::getInstance().getRobotPose(global_pose);
   }
 
   void CostmapWrapper::setPaddedRobotFootprint(
       const std::vector< NS_DataType::Point >& points)
   {
+    unsigned long hash = hashFootprint(points);
+    if(footprint_hash_valid && hash == footprint_hash && !padded_footprint.empty())
+      return;
+
+    footprint_hash = hash;
+    footprint_hash_valid = true;
+
     padded_footprint = points;
     padFootprint(padded_footprint, footprint_padding_);
 
@@ -251,7 +240,7 @@ namespace NS_CostMap
     printf("costmap is initializing!\n");
     loadParameters();
 
-    layered_costmap = new LayeredCostmap(track_unknown_space_);
+    layered_costmap = new LayeredCostmap(track_unknown_space_, rolling_window_);
 
     if(layered_costmap)
     {
@@ -9,6 +9,7 @@
 #define _COSTMAP_COSTMAPWRAPPER_H_
 
 #include <vector>
+#include <string>
 #include "CostMap2D/CostMapLayer.h"
 #include <DataSet/DataType/OccupancyGrid.h>
 #include <DataSet/DataType/Point.h>
@@ -23,11 +24,20 @@ namespace NS_CostMap
   class CostmapWrapper
   {
   public:
-    CostmapWrapper();
+    /**
+     * @brief Constructor
+     * @param config_file The configuration file the costmap parameters are read from
+     * @param rolling_window Default of the rolling_window parameter
+     */
+    CostmapWrapper(const std::string& config_file = "costmap.xml",
+                   bool rolling_window = false);
     virtual
     ~CostmapWrapper();
   private:
+    std::string config_file_;
+
     bool track_unknown_space_;
+    bool rolling_window_; ///< Keep a window of map_width x map_height centred on the robot
     std::string footprint_;
 
     double map_update_frequency_;
@@ -61,14 +71,13 @@ namespace NS_CostMap
 
     std::vector< NS_DataType::Point > footprint_from_param;
 
+    unsigned long footprint_hash; ///< Hash of the unpadded footprint last passed to setPaddedRobotFootprint()
+    bool footprint_hash_valid;
+
     bool got_map;
 
     bool running;
 
-    NS_Service::Client< NS_ServiceType::ServiceTransform >* odom_tf_cli;
-
-    NS_Service::Client< NS_ServiceType::ServiceTransform >* map_tf_cli;
-
   private:
     void
     loadParameters();
@@ -111,6 +120,16 @@ namespace NS_CostMap
     }
     ;
 
+    /**
+     * @brief Get the latest published copy of the costmap, safe to read
+     * without the costmap lock while the map keeps updating
+     */
+    CostmapSnapshotPtr
+    getSnapshot()
+    {
+      return layered_costmap->getSnapshot();
+    }
+
     std::vector< NS_DataType::Point > getRobotFootprint()
     {
       //return padded_footprint;
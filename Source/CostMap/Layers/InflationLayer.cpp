@@ -17,8 +17,12 @@ namespace NS_CostMap
 
   InflationLayer::InflationLayer()
       : inflation_radius_(0), weight_(0), cell_inflation_radius_(0),
-        cached_cell_inflation_radius_(0), seen_(NULL), cached_costs_(NULL),
-        cached_distances_(NULL),
+        cached_cell_inflation_radius_(0), current_level_(0), seen_(NULL),
+        seen_size_(0), seen_epoch_(0), incremental_(true),
+        inflation_cache_(NULL), cache_valid_(false), cache_origin_x_(0.0),
+        cache_origin_y_(0.0), cache_width_(0),
+        cached_costs_(NULL), cached_distances_(NULL), cached_levels_(NULL),
+        cached_level_count_(0),
         last_min_x_(-std::numeric_limits< float >::max()),
         last_min_y_(-std::numeric_limits< float >::max()),
         last_max_x_(std::numeric_limits< float >::max()),
@@ -37,6 +41,10 @@ namespace NS_CostMap
         delete[] seen_;
       seen_ = NULL;
       seen_size_ = 0;
+      if(inflation_cache_)
+        delete[] inflation_cache_;
+      inflation_cache_ = NULL;
+      cache_valid_ = false;
       need_reinflation_ = false;
       enabled_ = true;
     }
@@ -59,6 +67,11 @@ namespace NS_CostMap
     double cost_scaling_factor_ = parameter.getParameter("cost_scaling_factor", 2.58f);
     ///////////////////////////////////////////////////////
 
+    if(parameter.getParameter("incremental_inflation", 1) == 1)
+      incremental_ = true;
+    else
+      incremental_ = false;
+
     matchSize();
 
     setInflationParameters(inflation_radius_, cost_scaling_factor_);
@@ -77,7 +90,14 @@ namespace NS_CostMap
     if(seen_)
       delete[] seen_;
     seen_size_ = size_x * size_y;
-    seen_ = new bool[seen_size_];
+    seen_ = new unsigned char[seen_size_];
+    memset(seen_, 0, seen_size_ * sizeof(unsigned char));
+    seen_epoch_ = 0;
+
+    if(inflation_cache_)
+      delete[] inflation_cache_;
+    inflation_cache_ = new unsigned char[seen_size_];
+    cache_valid_ = false;
   }
 
   void InflationLayer::updateBounds(double robot_x, double robot_y,
@@ -118,8 +138,16 @@ namespace NS_CostMap
 
   void InflationLayer::onFootprintChanged()
   {
-    inscribed_radius_ = layered_costmap_->getInscribedRadius();
-    cell_inflation_radius_ = cellDistance(inflation_radius_);
+    double inscribed_radius = layered_costmap_->getInscribedRadius();
+    unsigned int cell_inflation_radius = cellDistance(inflation_radius_);
+
+    // the kernels only depend on these two, keep them if neither changed
+    if(cached_costs_ != NULL && inscribed_radius == inscribed_radius_ &&
+       cell_inflation_radius == cell_inflation_radius_)
+      return;
+
+    inscribed_radius_ = inscribed_radius;
+    cell_inflation_radius_ = cell_inflation_radius;
     computeCaches();
     need_reinflation_ = true;
     /*
@@ -137,8 +165,9 @@ namespace NS_CostMap
     if(!enabled_)
       return;
 
-    // make sure the inflation queue is empty at the beginning of the cycle (should always be true)
-    assert(inflation_queue_.empty());
+    // make sure the inflation buckets are empty at the beginning of the cycle (should always be true)
+    for(unsigned int level = 0; level < inflation_cells_.size(); ++level)
+      assert(inflation_cells_[level].empty());
 
     unsigned char* master_array = master_grid.getCharMap();
     unsigned int size_x = master_grid.getSizeInCellsX();
@@ -148,16 +177,24 @@ namespace NS_CostMap
     {
       printf("InflationLayer::updateCosts(): seen_ array is NULL\n");
       seen_size_ = size_x * size_y;
-      seen_ = new bool[seen_size_];
+      seen_ = new unsigned char[seen_size_];
+      memset(seen_, 0, seen_size_ * sizeof(unsigned char));
+      seen_epoch_ = 0;
+      cache_valid_ = false;
     }
     else if(seen_size_ != size_x * size_y)
     {
       printf("InflationLayer::updateCosts(): seen_ array size is wrong\n");
       delete[] seen_;
       seen_size_ = size_x * size_y;
-      seen_ = new bool[seen_size_];
+      seen_ = new unsigned char[seen_size_];
+      memset(seen_, 0, seen_size_ * sizeof(unsigned char));
+      seen_epoch_ = 0;
+      if(inflation_cache_)
+        delete[] inflation_cache_;
+      inflation_cache_ = NULL;
+      cache_valid_ = false;
     }
-    memset(seen_, false, size_x * size_y * sizeof(bool));
 
     // We need to include in the inflation cells outside the bounding
     // box min_i...max_j, by the amount cell_inflation_radius_.  Cells
@@ -173,6 +210,14 @@ namespace NS_CostMap
     max_i = std::min(int(size_x), max_i);
     max_j = std::min(int(size_y), max_j);
 
+    if(incremental_)
+    {
+      updateCostsIncremental(master_grid, min_i, min_j, max_i, max_j);
+      return;
+    }
+
+    nextSeenEpoch();
+
     for(int j = min_j; j < max_j; j++)
     {
       for(int i = min_i; i < max_i; i++)
@@ -186,50 +231,209 @@ namespace NS_CostMap
       }
     }
 
-    while(!inflation_queue_.empty())
+    propagateCosts(master_array, size_x, size_y, true, 0, 0, size_x, size_y);
+  }
+
+  void InflationLayer::updateCostsIncremental(Costmap2D& master_grid,
+                                              int min_i, int min_j, int max_i,
+                                              int max_j)
+  {
+    unsigned char* master_array = master_grid.getCharMap();
+    unsigned int size_x = master_grid.getSizeInCellsX();
+    unsigned int size_y = master_grid.getSizeInCellsY();
+
+    if(inflation_cache_ == NULL)
+    {
+      inflation_cache_ = new unsigned char[size_x * size_y];
+      cache_valid_ = false;
+    }
+
+    // a rolling window moved, the cached cells no longer line up with the master
+    if(master_grid.getOriginX() != cache_origin_x_ || master_grid.getOriginY() != cache_origin_y_)
+    {
+      cache_origin_x_ = master_grid.getOriginX();
+      cache_origin_y_ = master_grid.getOriginY();
+      cache_valid_ = false;
+    }
+
+    // the region whose inflation has to be recomputed this cycle
+    int dirty_min_i = size_x, dirty_min_j = size_y, dirty_max_i = 0,
+        dirty_max_j = 0;
+
+    if(!cache_valid_)
+    {
+      // nothing to compare against, so rebuild the cache for the whole map
+      memset(inflation_cache_, 0, size_x * size_y * sizeof(unsigned char));
+      dirty_min_i = 0;
+      dirty_min_j = 0;
+      dirty_max_i = size_x;
+      dirty_max_j = size_y;
+    }
+    else
     {
-      // get the highest priority cell and pop it off the priority queue
-      const CellData& current_cell = inflation_queue_.top();
+      // only lethal cells inside the window can have changed, the cache
+      // keeps LETHAL_OBSTACLE exactly on the lethal cells of the last cycle
+      for(int j = min_j; j < max_j; j++)
+      {
+        unsigned int index = j * size_x + min_i;
+        for(int i = min_i; i < max_i; i++, index++)
+        {
+          if((master_array[index] == LETHAL_OBSTACLE) != (inflation_cache_[index] == LETHAL_OBSTACLE))
+          {
+            dirty_min_i = std::min(dirty_min_i, i);
+            dirty_min_j = std::min(dirty_min_j, j);
+            dirty_max_i = std::max(dirty_max_i, i + 1);
+            dirty_max_j = std::max(dirty_max_j, j + 1);
+          }
+        }
+      }
+
+      if(dirty_min_i < dirty_max_i)
+      {
+        // every cell within the inflation radius of a changed cell may change
+        dirty_min_i = std::max(0, dirty_min_i - (int)cell_inflation_radius_);
+        dirty_min_j = std::max(0, dirty_min_j - (int)cell_inflation_radius_);
+        dirty_max_i = std::min(int(size_x),
+                               dirty_max_i + (int)cell_inflation_radius_);
+        dirty_max_j = std::min(int(size_y),
+                               dirty_max_j + (int)cell_inflation_radius_);
+
+        for(int j = dirty_min_j; j < dirty_max_j; j++)
+          memset(inflation_cache_ + j * size_x + dirty_min_i, 0,
+                 (dirty_max_i - dirty_min_i) * sizeof(unsigned char));
+      }
+    }
 
-      unsigned int index = current_cell.index_;
-      unsigned int mx = current_cell.x_;
-      unsigned int my = current_cell.y_;
-      unsigned int sx = current_cell.src_x_;
-      unsigned int sy = current_cell.src_y_;
+    if(dirty_min_i < dirty_max_i)
+    {
+      nextSeenEpoch();
 
-      // pop once we have our cell info
-      inflation_queue_.pop();
+      // seed with every lethal cell that can reach the dirty region
+      int seed_min_i = std::max(0, dirty_min_i - (int)cell_inflation_radius_);
+      int seed_min_j = std::max(0, dirty_min_j - (int)cell_inflation_radius_);
+      int seed_max_i = std::min(int(size_x),
+                                dirty_max_i + (int)cell_inflation_radius_);
+      int seed_max_j = std::min(int(size_y),
+                                dirty_max_j + (int)cell_inflation_radius_);
 
-      // set the cost of the cell being inserted
-      if(seen_[index])
+      for(int j = seed_min_j; j < seed_max_j; j++)
       {
-        continue;
+        for(int i = seed_min_i; i < seed_max_i; i++)
+        {
+          int index = master_grid.getIndex(i, j);
+          if(master_array[index] == LETHAL_OBSTACLE)
+          {
+            enqueue(index, i, j, i, j);
+          }
+        }
       }
 
-      seen_[index] = true;
+      propagateCosts(inflation_cache_, size_x, size_y, false, dirty_min_i,
+                     dirty_min_j, dirty_max_i, dirty_max_j);
+      cache_valid_ = true;
+    }
 
-      // assign the cost associated with the distance from an obstacle to the cell
+    // the master grid was reset inside the window, so merge the cached costs back
+    for(int j = min_j; j < max_j; j++)
+    {
+      unsigned int index = j * size_x + min_i;
+      for(int i = min_i; i < max_i; i++, index++)
+      {
+        unsigned char cost = inflation_cache_[index];
+        if(cost == 0)
+          continue;
+
+        unsigned char old_cost = master_array[index];
+        if(old_cost == NO_INFORMATION && cost >= INSCRIBED_INFLATED_OBSTACLE)
+          master_array[index] = cost;
+        else
+          master_array[index] = std::max(old_cost, cost);
+      }
+    }
+  }
+
+  void InflationLayer::propagateCosts(unsigned char* grid, unsigned int size_x,
+                                      unsigned int size_y, bool merge,
+                                      int min_i, int min_j, int max_i,
+                                      int max_j)
+  {
+    // pop the buckets in increasing distance order, cells of one bucket in
+    // the order they were pushed; a bucket may grow while it is being
+    // processed so it is walked by index
+    for(current_level_ = 0; current_level_ < inflation_cells_.size();
+        ++current_level_)
+    {
+      std::vector< CellData >& bucket = inflation_cells_[current_level_];
+      for(unsigned int i = 0; i < bucket.size(); ++i)
+      {
+        propagateCell(bucket[i], grid, size_x, size_y, merge, min_i, min_j,
+                      max_i, max_j);
+      }
+      bucket.clear();
+    }
+    current_level_ = 0;
+  }
+
+  inline void InflationLayer::propagateCell(CellData current_cell,
+                                            unsigned char* grid,
+                                            unsigned int size_x,
+                                            unsigned int size_y, bool merge,
+                                            int min_i, int min_j, int max_i,
+                                            int max_j)
+  {
+    unsigned int index = current_cell.index_;
+    unsigned int mx = current_cell.x_;
+    unsigned int my = current_cell.y_;
+    unsigned int sx = current_cell.src_x_;
+    unsigned int sy = current_cell.src_y_;
+
+    // set the cost of the cell being inserted
+    if(seen_[index] == seen_epoch_)
+    {
+      return;
+    }
+
+    seen_[index] = seen_epoch_;
+
+    // assign the cost associated with the distance from an obstacle to the cell
+    if((int)mx >= min_i && (int)mx < max_i && (int)my >= min_j && (int)my < max_j)
+    {
       unsigned char cost = costLookup(mx, my, sx, sy);
-      unsigned char old_cost = master_array[index];
-      if(old_cost == NO_INFORMATION && cost >= INSCRIBED_INFLATED_OBSTACLE)
-        master_array[index] = cost;
+      if(!merge)
+        grid[index] = cost;
       else
-        master_array[index] = std::max(old_cost, cost);
-
-      // attempt to put the neighbors of the current cell onto the queue
-      if(mx > 0)
-        enqueue(index - 1, mx - 1, my, sx, sy);
-      if(my > 0)
-        enqueue(index - size_x, mx, my - 1, sx, sy);
-      if(mx < size_x - 1)
-        enqueue(index + 1, mx + 1, my, sx, sy);
-      if(my < size_y - 1)
-        enqueue(index + size_x, mx, my + 1, sx, sy);
+      {
+        unsigned char old_cost = grid[index];
+        if(old_cost == NO_INFORMATION && cost >= INSCRIBED_INFLATED_OBSTACLE)
+          grid[index] = cost;
+        else
+          grid[index] = std::max(old_cost, cost);
+      }
+    }
+
+    // attempt to put the neighbors of the current cell onto the queue
+    if(mx > 0)
+      enqueue(index - 1, mx - 1, my, sx, sy);
+    if(my > 0)
+      enqueue(index - size_x, mx, my - 1, sx, sy);
+    if(mx < size_x - 1)
+      enqueue(index + 1, mx + 1, my, sx, sy);
+    if(my < size_y - 1)
+      enqueue(index + size_x, mx, my + 1, sx, sy);
+  }
+
+  void InflationLayer::nextSeenEpoch()
+  {
+    // a zeroed array means nothing is seen, so the epoch skips zero on wrap around
+    if(++seen_epoch_ == 0)
+    {
+      memset(seen_, 0, seen_size_ * sizeof(unsigned char));
+      seen_epoch_ = 1;
     }
   }
 
   /**
-   * @brief  Given an index of a cell in the costmap, place it into a priority queue for obstacle inflation
+   * @brief  Given an index of a cell in the costmap, place it into the bucket of its distance level for obstacle inflation
    * @param  grid The costmap
    * @param  index The index of the cell
    * @param  mx The x coordinate of the cell (can be computed from the index, but saves time to store it)
@@ -241,18 +445,20 @@ namespace NS_CostMap
                                       unsigned int my, unsigned int src_x,
                                       unsigned int src_y)
   {
-    if(!seen_[index])
+    if(seen_[index] != seen_epoch_)
     {
-      // we compute our distance table one cell further than the inflation radius dictates so we can make the check below
-      double distance = distanceLookup(mx, my, src_x, src_y);
+      // we compute our level table one cell further than the inflation radius dictates so we can make the check below
+      unsigned int level = levelLookup(mx, my, src_x, src_y);
 
       // we only want to put the cell in the queue if it is within the inflation radius of the obstacle point
-      if(distance > cell_inflation_radius_)
+      if(level >= cached_level_count_)
         return;
 
-      // push the cell data onto the queue and mark
-      CellData data(distance, index, mx, my, src_x, src_y);
-      inflation_queue_.push(data);
+      // a level that is already popped is handled with the current one
+      if(level < current_level_)
+        level = current_level_;
+
+      inflation_cells_[level].push_back(CellData(index, mx, my, src_x, src_y));
     }
   }
 
@@ -261,60 +467,78 @@ namespace NS_CostMap
     if(cell_inflation_radius_ == 0)
       return;
 
-    // based on the inflation radius... compute distance and cost caches
+    // based on the inflation radius... compute distance, level and cost caches
     if(cell_inflation_radius_ != cached_cell_inflation_radius_)
     {
       deleteKernels();
 
-      cached_costs_ = new unsigned char*[cell_inflation_radius_ + 2];
-      cached_distances_ = new double*[cell_inflation_radius_ + 2];
+      cache_width_ = cell_inflation_radius_ + 2;
+      unsigned int cache_size = cache_width_ * cache_width_;
+      cached_costs_ = new unsigned char[cache_size];
+      cached_distances_ = new double[cache_size];
+      cached_levels_ = new unsigned int[cache_size];
 
-      for(unsigned int i = 0; i <= cell_inflation_radius_ + 1; ++i)
+      for(unsigned int i = 0; i < cache_width_; ++i)
       {
-        cached_costs_[i] = new unsigned char[cell_inflation_radius_ + 2];
-        cached_distances_[i] = new double[cell_inflation_radius_ + 2];
-        for(unsigned int j = 0; j <= cell_inflation_radius_ + 1; ++j)
+        for(unsigned int j = 0; j < cache_width_; ++j)
         {
-          cached_distances_[i][j] = hypot(i, j);
+          cached_distances_[i * cache_width_ + j] = hypot(i, j);
         }
       }
 
+      // rank the distinct distances within the inflation radius, each rank
+      // is one bucket of the inflation queue
+      std::vector< double > levels;
+      for(unsigned int k = 0; k < cache_size; ++k)
+      {
+        if(cached_distances_[k] <= cell_inflation_radius_)
+          levels.push_back(cached_distances_[k]);
+      }
+      std::sort(levels.begin(), levels.end());
+      levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+      cached_level_count_ = levels.size();
+
+      for(unsigned int k = 0; k < cache_size; ++k)
+      {
+        cached_levels_[k] = std::lower_bound(levels.begin(), levels.end(),
+                                             cached_distances_[k])
+            - levels.begin();
+      }
+
+      inflation_cells_.clear();
+      inflation_cells_.resize(cached_level_count_);
+
       cached_cell_inflation_radius_ = cell_inflation_radius_;
     }
 
-    for(unsigned int i = 0; i <= cell_inflation_radius_ + 1; ++i)
+    for(unsigned int k = 0; k < cache_width_ * cache_width_; ++k)
     {
-      for(unsigned int j = 0; j <= cell_inflation_radius_ + 1; ++j)
-      {
-        cached_costs_[i][j] = computeCost(cached_distances_[i][j]);
-      }
+      cached_costs_[k] = computeCost(cached_distances_[k]);
     }
+
+    // the cached inflation was built with the old kernel
+    cache_valid_ = false;
   }
 
   void InflationLayer::deleteKernels()
   {
     if(cached_distances_ != NULL)
     {
-      for(unsigned int i = 0; i <= cached_cell_inflation_radius_ + 1; ++i)
-      {
-        if(cached_distances_[i])
-          delete[] cached_distances_[i];
-      }
-      if(cached_distances_)
-        delete[] cached_distances_;
+      delete[] cached_distances_;
       cached_distances_ = NULL;
     }
 
     if(cached_costs_ != NULL)
     {
-      for(unsigned int i = 0; i <= cached_cell_inflation_radius_ + 1; ++i)
-      {
-        if(cached_costs_[i])
-          delete[] cached_costs_[i];
-      }
       delete[] cached_costs_;
       cached_costs_ = NULL;
     }
+
+    if(cached_levels_ != NULL)
+    {
+      delete[] cached_levels_;
+      cached_levels_ = NULL;
+    }
   }
 
   void InflationLayer::setInflationParameters(double inflation_radius,
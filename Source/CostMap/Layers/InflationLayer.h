@@ -6,7 +6,7 @@
 #include <DataSet/DataType/OccupancyGrid.h>
 #include <DataSet/DataType/OccupancyGridUpdate.h>
 #include <boost/thread/thread.hpp>
-#include <queue>
+#include <vector>
 
 namespace NS_CostMap
 {
@@ -19,7 +19,6 @@ namespace NS_CostMap
   public:
     /**
      * @brief  Constructor for a CellData objects
-     * @param  d The distance to the nearest obstacle, used for ordering in the priority queue
      * @param  i The index of the cell in the cost map
      * @param  x The x coordinate of the cell in the cost map
      * @param  y The y coordinate of the cell in the cost map
@@ -27,26 +26,16 @@ namespace NS_CostMap
      * @param  sy The y coordinate of the closest obstacle cell in the costmap
      * @return
      */
-    CellData(double d, double i, unsigned int x, unsigned int y,
-             unsigned int sx, unsigned int sy)
-        : distance_(d), index_(i), x_(x), y_(y), src_x_(sx), src_y_(sy)
+    CellData(unsigned int i, unsigned int x, unsigned int y, unsigned int sx,
+             unsigned int sy)
+        : index_(i), x_(x), y_(y), src_x_(sx), src_y_(sy)
     {
     }
-    double distance_;
     unsigned int index_;
     unsigned int x_, y_;
     unsigned int src_x_, src_y_;
   };
 
-  /**
-   * @brief Provide an ordering between CellData objects in the priority queue
-   * @return We want the lowest distance to have the highest priority... so this returns true if a has higher priority than b
-   */
-  inline bool operator<(const CellData &a, const CellData &b)
-  {
-    return a.distance_ > b.distance_;
-  }
-
   class InflationLayer: public Layer
   {
   public:
@@ -55,6 +44,10 @@ namespace NS_CostMap
     virtual ~InflationLayer()
     {
       deleteKernels();
+      if(seen_)
+        delete[] seen_;
+      if(inflation_cache_)
+        delete[] inflation_cache_;
     }
 
     virtual void
@@ -138,7 +131,7 @@ namespace NS_CostMap
     {
       unsigned int dx = abs(mx - src_x);
       unsigned int dy = abs(my - src_y);
-      return cached_distances_[dx][dy];
+      return cached_distances_[dx * cache_width_ + dy];
     }
 
     /**
@@ -153,7 +146,22 @@ namespace NS_CostMap
     {
       unsigned int dx = abs(mx - src_x);
       unsigned int dy = abs(my - src_y);
-      return cached_costs_[dx][dy];
+      return cached_costs_[dx * cache_width_ + dy];
+    }
+
+    /**
+     * @brief  Lookup the pre-computed distance level
+     * @param mx The x coordinate of the current cell
+     * @param my The y coordinate of the current cell
+     * @param src_x The x coordinate of the source cell
+     * @param src_y The y coordinate of the source cell
+     * @return The rank of the distance among all distances in the kernel, cached_level_count_ if beyond the inflation radius
+     */
+    inline unsigned int levelLookup(int mx, int my, int src_x, int src_y)
+    {
+      unsigned int dx = abs(mx - src_x);
+      unsigned int dy = abs(my - src_y);
+      return cached_levels_[dx * cache_width_ + dy];
     }
 
     void
@@ -164,6 +172,43 @@ namespace NS_CostMap
     inflate_area(int min_i, int min_j, int max_i, int max_j,
                  unsigned char* master_grid);
 
+    /**
+     * @brief  Advance the visit epoch, clearing seen_ only when the epoch wraps
+     */
+    void
+    nextSeenEpoch();
+
+    /**
+     * @brief  Pop cells off the inflation queue and assign their costs
+     * @param grid The grid receiving the costs
+     * @param size_x The x size of the grid
+     * @param size_y The y size of the grid
+     * @param merge True to merge into a master grid, false to overwrite an inflation cache
+     * @param min_i The lower x bound of the cells that may be written
+     * @param min_j The lower y bound of the cells that may be written
+     * @param max_i The upper x bound (exclusive) of the cells that may be written
+     * @param max_j The upper y bound (exclusive) of the cells that may be written
+     */
+    void
+    propagateCosts(unsigned char* grid, unsigned int size_x,
+                   unsigned int size_y, bool merge, int min_i, int min_j,
+                   int max_i, int max_j);
+
+    /**
+     * @brief  Assign the cost of one popped cell and enqueue its neighbors
+     */
+    inline void
+    propagateCell(CellData current_cell, unsigned char* grid,
+                  unsigned int size_x, unsigned int size_y, bool merge,
+                  int min_i, int min_j, int max_i, int max_j);
+
+    /**
+     * @brief  Re-inflate only around lethal cells that appeared or disappeared since the last cycle
+     */
+    void
+    updateCostsIncremental(Costmap2D& master_grid, int min_i, int min_j,
+                           int max_i, int max_j);
+
     unsigned int cellDistance(double world_dist)
     {
       return layered_costmap_->getCostmap()->cellDistance(world_dist);
@@ -176,15 +221,25 @@ namespace NS_CostMap
     double inflation_radius_, inscribed_radius_, weight_;
     unsigned int cell_inflation_radius_;
     unsigned int cached_cell_inflation_radius_;
-    std::priority_queue< CellData > inflation_queue_;
+    std::vector< std::vector< CellData > > inflation_cells_; ///< Cells waiting for inflation, bucketed by distance level
+    unsigned int current_level_; ///< The level being popped by propagateCosts()
 
     double resolution_;
 
-    bool* seen_;
+    unsigned char* seen_; ///< Visit markers, a cell is seen when it holds seen_epoch_
     int seen_size_;
-
-    unsigned char** cached_costs_;
-    double** cached_distances_;
+    unsigned char seen_epoch_;
+
+    bool incremental_; ///< Only re-propagate costs around changed lethal cells
+    unsigned char* inflation_cache_; ///< Inflation costs of the last cycle, LETHAL_OBSTACLE marks the lethal cells
+    bool cache_valid_;
+    double cache_origin_x_, cache_origin_y_; ///< Master origin the inflation cache was built at
+
+    unsigned int cache_width_; ///< Row length of the flat kernel tables, cached_cell_inflation_radius_ + 2
+    unsigned char* cached_costs_;
+    double* cached_distances_;
+    unsigned int* cached_levels_;
+    unsigned int cached_level_count_;
     double last_min_x_, last_min_y_, last_max_x_, last_max_y_;
 
     bool need_reinflation_; ///< Indicates that the entire costmap should be reinflated next time around.
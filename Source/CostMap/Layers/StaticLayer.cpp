@@ -16,6 +16,9 @@ namespace NS_CostMap
   {
     map_cli = new NS_Service::Client< NS_ServiceType::ServiceMap >("MAP");
     active = false;
+    map_received = false;
+    has_updated_data = false;
+    map_version_ = 0;
   }
 
   StaticLayer::~StaticLayer()
@@ -81,11 +84,17 @@ namespace NS_CostMap
 
   void StaticLayer::matchSize()
   {
+    // a rolling master is only a window, this layer keeps the whole map
+    if(layered_costmap_->isRolling())
+      return;
+
     Costmap2D* master = layered_costmap_->getCostmap();
     resizeMap(master->getSizeInCellsX(), master->getSizeInCellsY(),
               master->getResolution(), master->getOriginX(),
               master->getOriginY());
 
+    // resizing cleared the layer, the next map has to be written in full
+    row_checksums.clear();
   }
 
   unsigned char StaticLayer::interpretValue(unsigned char value)
@@ -104,15 +113,32 @@ namespace NS_CostMap
     return scale * LETHAL_OBSTACLE;
   }
 
+  unsigned long StaticLayer::rowChecksum(const NS_DataType::OccupancyGrid& map,
+                                         unsigned int start,
+                                         unsigned int length)
+  {
+    // FNV-1a over the raw cell values
+    unsigned long checksum = 2166136261UL;
+    for(unsigned int i = start; i < start + length; ++i)
+    {
+      checksum ^= (unsigned char)map.data[i];
+      checksum *= 16777619UL;
+    }
+    return checksum;
+  }
+
   void StaticLayer::processMap(const NS_DataType::OccupancyGrid& new_map)
   {
     unsigned int size_x = new_map.info.width, size_y = new_map.info.height;
 
     //printf("Received a %d X %d map at %f m/pix\n", size_x, size_y, new_map.info.resolution);
 
+    // readers of copyMap() see either the whole old or the whole new map
+    boost::unique_lock< boost::mutex > map_guard(map_lock);
+
     // resize costmap if size, resolution or origin do not match
     Costmap2D* master = layered_costmap_->getCostmap();
-    if(master->getSizeInCellsX() != size_x || master->getSizeInCellsY() != size_y || master->getResolution() != new_map.info.resolution || master->getOriginX() != new_map.info.origin.position.x || master->getOriginY() != new_map.info.origin.position.y || !layered_costmap_->isSizeLocked())
+    if(!layered_costmap_->isRolling() && (master->getSizeInCellsX() != size_x || master->getSizeInCellsY() != size_y || master->getResolution() != new_map.info.resolution || master->getOriginX() != new_map.info.origin.position.x || master->getOriginY() != new_map.info.origin.position.y))
     {
       // Update the size of the layered costmap (and all layers, including this one)
       //printf("Resizing costmap to %d X %d at %f m/pix\n", size_x, size_y, new_map.info.resolution);
@@ -126,27 +152,85 @@ namespace NS_CostMap
       //printf("Resizing static layer to %d X %d at %f m/pix\n", size_x, size_y, new_map.info.resolution);
       resizeMap(size_x, size_y, new_map.info.resolution,
                 new_map.info.origin.position.x, new_map.info.origin.position.y);
+      row_checksums.clear();
+    }
+
+    if(new_map.data.size() < size_x * size_y)
+    {
+      printf("Static map data is smaller than %d X %d, ignored.\n", size_x,
+             size_y);
+      return;
     }
 
-    unsigned int index = 0;
+    bool full_update = row_checksums.size() != size_y;
+    if(full_update)
+      row_checksums.assign(size_y, 0);
 
-    // initialize the costmap with static data
+    // only reinterpret the rows whose checksum changed, and track the box
+    // of cells whose cost really changed
+    unsigned int min_x = size_x, min_y = size_y, max_x = 0, max_y = 0;
     for(unsigned int i = 0; i < size_y; ++i)
     {
+      unsigned int index = i * size_x;
+      unsigned long checksum = rowChecksum(new_map, index, size_x);
+      if(!full_update && checksum == row_checksums[i])
+        continue;
+      row_checksums[i] = checksum;
+
       for(unsigned int j = 0; j < size_x; ++j)
       {
         unsigned char value = new_map.data[index];
-        costmap_[index] = interpretValue(value);
+        unsigned char cost = interpretValue(value);
+        if(full_update || costmap_[index] != cost)
+        {
+          costmap_[index] = cost;
+          min_x = std::min(min_x, j);
+          max_x = std::max(max_x, j + 1);
+          min_y = std::min(min_y, i);
+          max_y = std::max(max_y, i + 1);
+        }
         ++index;
       }
     }
+    if(min_x < max_x)
+      map_version_++;
+    map_guard.unlock();
 
-    // we have a new map, update full size of map
-    x_ = y_ = 0;
-    width_ = size_x_;
-    height_ = size_y_;
+    boost::unique_lock< boost::mutex > lock(update_lock);
+    if(min_x < max_x)
+    {
+      // merge with a box not consumed by updateBounds() yet
+      if(has_updated_data)
+      {
+        min_x = std::min(min_x, x_);
+        min_y = std::min(min_y, y_);
+        max_x = std::max(max_x, x_ + width_);
+        max_y = std::max(max_y, y_ + height_);
+      }
+      x_ = min_x;
+      y_ = min_y;
+      width_ = max_x - min_x;
+      height_ = max_y - min_y;
+      has_updated_data = true;
+    }
     map_received = true;
-    has_updated_data = true;
+  }
+
+  unsigned long StaticLayer::getMapVersion()
+  {
+    boost::unique_lock< boost::mutex > lock(map_lock);
+    return map_version_;
+  }
+
+  unsigned long StaticLayer::copyMap(std::vector< unsigned char >& costs,
+                                     unsigned int& size_x,
+                                     unsigned int& size_y)
+  {
+    boost::unique_lock< boost::mutex > lock(map_lock);
+    size_x = size_x_;
+    size_y = size_y_;
+    costs.assign(costmap_, costmap_ + size_x_ * size_y_);
+    return map_version_;
   }
 
   void StaticLayer::activate()
@@ -172,14 +256,39 @@ namespace NS_CostMap
                                  double robot_yaw, double* min_x, double* min_y,
                                  double* max_x, double* max_y)
   {
+    boost::unique_lock< boost::mutex > lock(update_lock);
+    if(layered_costmap_->isRolling())
+    {
+      if(!map_received)
+        return;
+
+      // the window moves with the robot, so every cycle the whole part of
+      // the static map it covers has to be copied in again
+      useExtraBounds(min_x, min_y, max_x, max_y);
+
+      double wx, wy;
+      mapToWorld(0, 0, wx, wy);
+      *min_x = std::min(wx, *min_x);
+      *min_y = std::min(wy, *min_y);
+
+      mapToWorld(size_x_, size_y_, wx, wy);
+      *max_x = std::max(wx, *max_x);
+      *max_y = std::max(wy, *max_y);
+
+      has_updated_data = false;
+      return;
+    }
+
     if(!map_received || !(has_updated_data || has_extra_bounds_))
     {
-      printf("Not update bounds.\n");
       return;
     }
 
     useExtraBounds(min_x, min_y, max_x, max_y);
 
+    if(!has_updated_data)
+      return;
+
     double wx, wy;
 
     mapToWorld(x_, y_, wx, wy);
@@ -203,10 +312,37 @@ namespace NS_CostMap
     }
 
     // if not rolling, the layered costmap (master_grid) has same coordinates as this layer
-    if(!use_maximum_)
-      updateWithTrueOverwrite(master_grid, min_i, min_j, max_i, max_j);
-    else
-      updateWithMax(master_grid, min_i, min_j, max_i, max_j);
+    if(!layered_costmap_->isRolling())
+    {
+      if(!use_maximum_)
+        updateWithTrueOverwrite(master_grid, min_i, min_j, max_i, max_j);
+      else
+        updateWithMax(master_grid, min_i, min_j, max_i, max_j);
+      return;
+    }
+
+    // the master is a window, look every cell of it up in this layer by world coordinates
+    unsigned int mx, my;
+    double wx, wy;
+    for(int j = min_j; j < max_j; j++)
+    {
+      for(int i = min_i; i < max_i; i++)
+      {
+        master_grid.mapToWorld(i, j, wx, wy);
+        if(!worldToMap(wx, wy, mx, my))
+          continue;
+
+        unsigned char cost = getCost(mx, my);
+        if(!use_maximum_)
+          master_grid.setCost(i, j, cost);
+        else if(cost != NO_INFORMATION)
+        {
+          unsigned char old_cost = master_grid.getCost(i, j);
+          if(old_cost == NO_INFORMATION || old_cost < cost)
+            master_grid.setCost(i, j, cost);
+        }
+      }
+    }
   }
 
 }  // namespace costmap_2d
@@ -37,11 +37,32 @@ namespace NS_CostMap
     virtual void
     matchSize();
 
+    /**
+     * @brief Number of times the cells of the static map changed, 0 before the first map
+     */
+    unsigned long
+    getMapVersion();
+
+    /**
+     * @brief Copy the costs of the static map
+     * @return The version of the copied map, 0 before the first map
+     */
+    unsigned long
+    copyMap(std::vector< unsigned char >& costs, unsigned int& size_x,
+            unsigned int& size_y);
+
   private:
 
     unsigned char
     interpretValue(unsigned char value);
 
+    /**
+     * @brief Checksum of one row of raw map data, used to skip rows that did not change
+     */
+    unsigned long
+    rowChecksum(const NS_DataType::OccupancyGrid& map, unsigned int start,
+                unsigned int length);
+
   private:
     unsigned int x_, y_, width_, height_;
     bool track_unknown_space_;
@@ -63,6 +84,14 @@ namespace NS_CostMap
 
     bool has_updated_data;
 
+    boost::mutex update_lock; ///< Guards the dirty box x_, y_, width_, height_ and has_updated_data
+
+    boost::mutex map_lock; ///< Guards the cells of the static map while processMap() writes them, and map_version_
+
+    unsigned long map_version_;
+
+    std::vector< unsigned long > row_checksums; ///< Checksum of every row of the last processed map, empty when the layer must be fully rewritten
+
     NS_Service::Client< NS_ServiceType::ServiceMap >* map_cli;
 
     void
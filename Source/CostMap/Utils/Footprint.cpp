@@ -117,6 +117,24 @@ namespace NS_CostMap
     }
   }
 
+  unsigned long hashFootprint(
+      const std::vector< NS_DataType::Point >& footprint)
+  {
+    // FNV-1a over the raw bytes of every vertex
+    unsigned long hash = 2166136261UL;
+    for(unsigned int i = 0; i < footprint.size(); i++)
+    {
+      double coords[2] = { footprint[i].x, footprint[i].y };
+      const unsigned char* bytes = (const unsigned char*)coords;
+      for(unsigned int b = 0; b < sizeof(coords); b++)
+      {
+        hash ^= bytes[b];
+        hash *= 16777619UL;
+      }
+    }
+    return hash;
+  }
+
   void padFootprint(std::vector< NS_DataType::Point >& footprint,
                     double padding)
   {
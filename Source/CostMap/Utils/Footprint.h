@@ -71,6 +71,15 @@ namespace NS_CostMap
                      const std::vector< NS_DataType::Point >& footprint_spec,
                      NS_DataType::PolygonStamped & oriented_footprint);
 
+  /**
+   * @brief Compute a content hash of the footprint polygon
+   *
+   * Two footprints with the same points in the same order give the same hash,
+   * so it can be used to detect whether a footprint really changed.
+   */
+  unsigned long
+  hashFootprint(const std::vector< NS_DataType::Point >& footprint);
+
   /**
    * @brief Adds the specified amount of padding to the footprint (in place)
    */
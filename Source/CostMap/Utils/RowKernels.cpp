@@ -0,0 +1,146 @@
+#include "RowKernels.h"
+#include "../CostMap2D/CostValues.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ROW_KERNEL_NAME "avx2"
+#define ROW_VEC __m256i
+#define ROW_WIDTH 32
+#define ROW_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define ROW_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#define ROW_SET1(c) _mm256_set1_epi8((char)(c))
+#define ROW_EQ(a, b) _mm256_cmpeq_epi8(a, b)
+#define ROW_MAX(a, b) _mm256_max_epu8(a, b)
+#define ROW_MIN(a, b) _mm256_min_epu8(a, b)
+#define ROW_ADDS(a, b) _mm256_adds_epu8(a, b)
+#define ROW_SELECT(mask, a, b) _mm256_blendv_epi8(b, a, mask)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define ROW_KERNEL_NAME "sse2"
+#define ROW_VEC __m128i
+#define ROW_WIDTH 16
+#define ROW_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define ROW_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#define ROW_SET1(c) _mm_set1_epi8((char)(c))
+#define ROW_EQ(a, b) _mm_cmpeq_epi8(a, b)
+#define ROW_MAX(a, b) _mm_max_epu8(a, b)
+#define ROW_MIN(a, b) _mm_min_epu8(a, b)
+#define ROW_ADDS(a, b) _mm_adds_epu8(a, b)
+#define ROW_SELECT(mask, a, b) \
+  _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define ROW_KERNEL_NAME "neon"
+#define ROW_VEC uint8x16_t
+#define ROW_WIDTH 16
+#define ROW_LOAD(p) vld1q_u8(p)
+#define ROW_STORE(p, v) vst1q_u8(p, v)
+#define ROW_SET1(c) vdupq_n_u8(c)
+#define ROW_EQ(a, b) vceqq_u8(a, b)
+#define ROW_MAX(a, b) vmaxq_u8(a, b)
+#define ROW_MIN(a, b) vminq_u8(a, b)
+#define ROW_ADDS(a, b) vqaddq_u8(a, b)
+#define ROW_SELECT(mask, a, b) vbslq_u8(mask, a, b)
+#else
+#if defined(__arm__)
+#warning "NEON is not enabled, the row kernels fall back to scalar loops (build with -mfpu=neon)"
+#endif
+#define ROW_KERNEL_NAME "scalar"
+#endif
+
+namespace NS_CostMap
+{
+
+  const char* rowKernelName()
+  {
+    return ROW_KERNEL_NAME;
+  }
+
+  void maxRow(unsigned char* master, const unsigned char* layer,
+              unsigned int len)
+  {
+    unsigned int i = 0;
+#ifdef ROW_VEC
+    const ROW_VEC unknown = ROW_SET1(NO_INFORMATION);
+    for(; i + ROW_WIDTH <= len; i += ROW_WIDTH)
+    {
+      ROW_VEC m = ROW_LOAD(master + i);
+      ROW_VEC l = ROW_LOAD(layer + i);
+      ROW_VEC cost = ROW_SELECT(ROW_EQ(m, unknown), l, ROW_MAX(m, l));
+      ROW_STORE(master + i, ROW_SELECT(ROW_EQ(l, unknown), m, cost));
+    }
+#endif
+    for(; i < len; i++)
+    {
+      if(layer[i] == NO_INFORMATION)
+        continue;
+
+      if(master[i] == NO_INFORMATION || master[i] < layer[i])
+        master[i] = layer[i];
+    }
+  }
+
+  void overwriteRow(unsigned char* master, const unsigned char* layer,
+                    unsigned int len)
+  {
+    unsigned int i = 0;
+#ifdef ROW_VEC
+    const ROW_VEC unknown = ROW_SET1(NO_INFORMATION);
+    for(; i + ROW_WIDTH <= len; i += ROW_WIDTH)
+    {
+      ROW_VEC m = ROW_LOAD(master + i);
+      ROW_VEC l = ROW_LOAD(layer + i);
+      ROW_STORE(master + i, ROW_SELECT(ROW_EQ(l, unknown), m, l));
+    }
+#endif
+    for(; i < len; i++)
+    {
+      if(layer[i] != NO_INFORMATION)
+        master[i] = layer[i];
+    }
+  }
+
+  void trueOverwriteRow(unsigned char* master, const unsigned char* layer,
+                        unsigned int len)
+  {
+    memcpy(master, layer, len * sizeof(unsigned char));
+  }
+
+  void addRow(unsigned char* master, const unsigned char* layer,
+              unsigned int len)
+  {
+    unsigned int i = 0;
+#ifdef ROW_VEC
+    const ROW_VEC unknown = ROW_SET1(NO_INFORMATION);
+    const ROW_VEC cap = ROW_SET1(INSCRIBED_INFLATED_OBSTACLE - 1);
+    for(; i + ROW_WIDTH <= len; i += ROW_WIDTH)
+    {
+      ROW_VEC m = ROW_LOAD(master + i);
+      ROW_VEC l = ROW_LOAD(layer + i);
+      // a saturated sum is above the cap too, so min() gives the capped sum
+      ROW_VEC cost = ROW_SELECT(ROW_EQ(m, unknown), l,
+                                ROW_MIN(ROW_ADDS(m, l), cap));
+      ROW_STORE(master + i, ROW_SELECT(ROW_EQ(l, unknown), m, cost));
+    }
+#endif
+    for(; i < len; i++)
+    {
+      if(layer[i] == NO_INFORMATION)
+        continue;
+
+      unsigned char old_cost = master[i];
+      if(old_cost == NO_INFORMATION)
+        master[i] = layer[i];
+      else
+      {
+        int sum = old_cost + layer[i];
+        if(sum >= INSCRIBED_INFLATED_OBSTACLE)
+          master[i] = INSCRIBED_INFLATED_OBSTACLE - 1;
+        else
+          master[i] = sum;
+      }
+    }
+  }
+
+}  // namespace NS_CostMap
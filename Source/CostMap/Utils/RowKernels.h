@@ -0,0 +1,47 @@
+#ifndef _COSTMAP_ROW_KERNELS_H_
+#define _COSTMAP_ROW_KERNELS_H_
+
+/**
+ * Row kernels used to combine a layer into the master grid.
+ *
+ * The vector path is chosen at build time: AVX2 or SSE2 on x86, NEON on
+ * ARM when the compiler enables it (Build/ passes -mfpu=neon for
+ * RowKernels.cpp, an ARM build without it warns), and a scalar loop
+ * otherwise. Every path gives the same bytes as the scalar one.
+ */
+namespace NS_CostMap
+{
+  /**
+   * @brief Name of the vector path compiled in, "avx2", "sse2", "neon" or "scalar"
+   */
+  const char*
+  rowKernelName();
+
+  /**
+   * @brief master = layer where layer is known and master is unknown or lower
+   */
+  void
+  maxRow(unsigned char* master, const unsigned char* layer, unsigned int len);
+
+  /**
+   * @brief master = layer where layer is known
+   */
+  void
+  overwriteRow(unsigned char* master, const unsigned char* layer,
+               unsigned int len);
+
+  /**
+   * @brief master = layer for every cell
+   */
+  void
+  trueOverwriteRow(unsigned char* master, const unsigned char* layer,
+                   unsigned int len);
+
+  /**
+   * @brief master += layer where both are known, capped below INSCRIBED_INFLATED_OBSTACLE
+   */
+  void
+  addRow(unsigned char* master, const unsigned char* layer, unsigned int len);
+}
+
+#endif  // _COSTMAP_ROW_KERNELS_H_
@@ -0,0 +1,247 @@
+#include "TransformCache.h"
+#include <Parameter/Parameter.h>
+#include <Console/Console.h>
+#include <Time/Rate.h>
+#include <boost/thread/once.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+
+namespace NS_CostMap
+{
+  static TransformCache* transform_cache_instance = NULL;
+  static boost::once_flag transform_cache_once = BOOST_ONCE_INIT;
+
+  void TransformCache::createInstance()
+  {
+    transform_cache_instance = new TransformCache();
+  }
+
+  TransformCache& TransformCache::getInstance()
+  {
+    boost::call_once(&TransformCache::createInstance, transform_cache_once);
+    return *transform_cache_instance;
+  }
+
+  TransformCache::TransformCache()
+      : odom_buffer("BASE_ODOM_TF"), map_buffer("ODOM_MAP_TF")
+  {
+    update_frequency_ = 50.0;
+    cache_time_ = 1.0;
+    max_extrapolation_ = 0.05;
+    max_age_ = 0.5;
+    running = false;
+  }
+
+  TransformCache::~TransformCache()
+  {
+    stop();
+  }
+
+  void TransformCache::loadParameters()
+  {
+    NS_NaviCommon::Parameter parameter;
+
+    parameter.loadConfigurationFile("transform_cache.xml");
+
+    update_frequency_ = parameter.getParameter("update_frequency", 50.0f);
+    cache_time_ = parameter.getParameter("cache_time", 1.0f);
+    max_extrapolation_ = parameter.getParameter("max_extrapolation", 0.05f);
+    max_age_ = parameter.getParameter("max_age", 0.5f);
+  }
+
+  void TransformCache::start()
+  {
+    if(running)
+      return;
+
+    loadParameters();
+
+    running = true;
+    update_thread = boost::thread(
+        boost::bind(&TransformCache::updateLoop, this));
+  }
+
+  void TransformCache::stop()
+  {
+    if(!running)
+      return;
+
+    running = false;
+    update_thread.join();
+  }
+
+  void TransformCache::updateLoop()
+  {
+    NS_NaviCommon::Rate rate(update_frequency_);
+    unsigned long cycles = 0;
+    while(running)
+    {
+      fetch(odom_buffer);
+      fetch(map_buffer);
+
+      if(++cycles % 500 == 0)
+      {
+        TransformStats odom_stats = getOdomStats();
+        TransformStats map_stats = getMapStats();
+        NS_NaviCommon::console.debug(
+            "Transform cache ages, odom: last %.3fs max %.3fs stale %lu of %lu, map: last %.3fs max %.3fs stale %lu of %lu",
+            odom_stats.last_age, odom_stats.max_age, odom_stats.stale,
+            odom_stats.lookups, map_stats.last_age, map_stats.max_age,
+            map_stats.stale, map_stats.lookups);
+      }
+
+      rate.sleep();
+    }
+  }
+
+  bool TransformCache::fetch(TransformBuffer& buffer)
+  {
+    NS_ServiceType::ServiceTransform srv_transform;
+    if(buffer.client.call(srv_transform) == false || srv_transform.result == false)
+      return false;
+
+    TransformSample sample;
+    sample.stamp = NS_NaviCommon::Time::now();
+    NS_Transform::transformMsgToTF(srv_transform.transform, sample.transform);
+
+    boost::unique_lock< boost::mutex > lock(buffer_lock);
+    if(!buffer.samples.empty() && sample.stamp <= buffer.samples.back().stamp)
+      return false;
+
+    buffer.samples.push_back(sample);
+    buffer.stats.samples++;
+
+    // keep cache_time of history, but never less than two samples
+    while(buffer.samples.size() > 2 && (sample.stamp - buffer.samples.front().stamp).toSec() > cache_time_)
+      buffer.samples.pop_front();
+
+    return true;
+  }
+
+  NS_Transform::Transform TransformCache::interpolate(
+      const TransformSample& first, const TransformSample& second,
+      double ratio)
+  {
+    NS_Transform::Transform transform;
+    transform.setOrigin(
+        first.transform.getOrigin() * (1.0 - ratio) + second.transform.getOrigin() * ratio);
+    transform.setRotation(
+        first.transform.getRotation().slerp(second.transform.getRotation(),
+                                            ratio));
+    return transform;
+  }
+
+  bool TransformCache::lookup(TransformBuffer& buffer,
+                              const NS_NaviCommon::Time& time,
+                              bool extrapolate,
+                              NS_Transform::Transform& transform)
+  {
+    // nobody is polling, answer from a direct call like before
+    if(!running)
+      fetch(buffer);
+
+    NS_NaviCommon::Time now = NS_NaviCommon::Time::now();
+
+    boost::unique_lock< boost::mutex > lock(buffer_lock);
+    buffer.stats.lookups++;
+
+    if(buffer.samples.empty())
+    {
+      buffer.stats.stale++;
+      return false;
+    }
+
+    const TransformSample& newest = buffer.samples.back();
+    double age = (now - newest.stamp).toSec();
+    buffer.stats.last_age = age;
+    if(age > buffer.stats.max_age)
+      buffer.stats.max_age = age;
+
+    if(age > max_age_)
+    {
+      buffer.stats.stale++;
+      return false;
+    }
+
+    if(time.isZero() || time == newest.stamp)
+    {
+      transform = newest.transform;
+      return true;
+    }
+
+    if(time > newest.stamp)
+    {
+      if(!extrapolate || buffer.samples.size() < 2)
+      {
+        transform = newest.transform;
+        return true;
+      }
+
+      buffer.stats.extrapolated++;
+
+      // continue the motion between the last two samples, but not further
+      // than max_extrapolation past the newest one
+      const TransformSample& previous = buffer.samples[buffer.samples.size() - 2];
+      double span = (newest.stamp - previous.stamp).toSec();
+      double ahead = std::min((time - newest.stamp).toSec(), max_extrapolation_);
+      transform = interpolate(previous, newest, 1.0 + ahead / span);
+      return true;
+    }
+
+    if(time <= buffer.samples.front().stamp)
+    {
+      transform = buffer.samples.front().transform;
+      return true;
+    }
+
+    // the newest sample is usually close, search backwards
+    unsigned int i = buffer.samples.size() - 1;
+    while(buffer.samples[i - 1].stamp > time)
+      --i;
+
+    const TransformSample& first = buffer.samples[i - 1];
+    const TransformSample& second = buffer.samples[i];
+    double ratio = (time - first.stamp).toSec() / (second.stamp - first.stamp).toSec();
+    transform = interpolate(first, second, ratio);
+    return true;
+  }
+
+  bool TransformCache::getOdomTransform(NS_Transform::Transform& transform,
+                                        const NS_NaviCommon::Time& time)
+  {
+    return lookup(odom_buffer, time, true, transform);
+  }
+
+  bool TransformCache::getMapTransform(NS_Transform::Transform& transform,
+                                       const NS_NaviCommon::Time& time)
+  {
+    // map->odom only changes in jumps when localization corrects it, a
+    // trend between two corrections says nothing about the next one
+    return lookup(map_buffer, time, false, transform);
+  }
+
+  bool TransformCache::getRobotPose(
+      NS_Transform::Stamped< NS_Transform::Pose >& global_pose,
+      const NS_NaviCommon::Time& time)
+  {
+    NS_Transform::Transform odom_tf, map_tf;
+    if(!getOdomTransform(odom_tf, time) || !getMapTransform(map_tf, time))
+      return false;
+
+    global_pose.setData(odom_tf * map_tf);
+    global_pose.stamp_ = time.isZero() ? NS_NaviCommon::Time::now() : time;
+    return true;
+  }
+
+  TransformStats TransformCache::getOdomStats()
+  {
+    boost::unique_lock< boost::mutex > lock(buffer_lock);
+    return odom_buffer.stats;
+  }
+
+  TransformStats TransformCache::getMapStats()
+  {
+    boost::unique_lock< boost::mutex > lock(buffer_lock);
+    return map_buffer.stats;
+  }
+}
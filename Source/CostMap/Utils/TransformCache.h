@@ -0,0 +1,159 @@
+#ifndef _COSTMAP_TRANSFORM_CACHE_H_
+#define _COSTMAP_TRANSFORM_CACHE_H_
+
+#include <deque>
+#include <string>
+#include <Transform/DataTypes.h>
+#include <Time/Time.h>
+#include <Service/ServiceType/ServiceTransform.h>
+#include <Service/Client.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace NS_CostMap
+{
+  /**
+   * @class TransformStats
+   * @brief Staleness counters of one cached transform
+   */
+  class TransformStats
+  {
+  public:
+    TransformStats()
+        : samples(0), lookups(0), extrapolated(0), stale(0), last_age(0.0),
+          max_age(0.0)
+    {
+    }
+
+    unsigned long samples; ///< Transforms received from the service
+    unsigned long lookups; ///< Lookups answered or refused
+    unsigned long extrapolated; ///< Lookups extrapolated past the newest sample
+    unsigned long stale; ///< Lookups refused because the newest sample was too old
+    double last_age; ///< Seconds between the newest sample and the last lookup
+    double max_age; ///< Largest last_age seen
+  };
+
+  /**
+   * @class TransformCache
+   * @brief Keeps a short history of the odom->base and map->odom transforms
+   *
+   * A background thread calls the BASE_ODOM_TF and ODOM_MAP_TF services at
+   * update_frequency and stamps every answer with its receive time. Lookups
+   * interpolate in that history, or extrapolate a bounded time past its end,
+   * so the control and planning loops never wait on the services.
+   */
+  class TransformCache
+  {
+  public:
+    /**
+     * @brief The cache shared by the costmaps, planners and the application
+     */
+    static TransformCache&
+    getInstance();
+
+    /**
+     * @brief Load transform_cache.xml and start polling the transform services
+     */
+    void
+    start();
+
+    void
+    stop();
+
+    /**
+     * @brief Transform from odom to base at time, a zero time means the newest sample
+     * @return false if no sample is younger than max_age
+     */
+    bool
+    getOdomTransform(NS_Transform::Transform& transform,
+                     const NS_NaviCommon::Time& time = NS_NaviCommon::Time());
+
+    /**
+     * @brief Transform from map to odom at time, a zero time means the newest sample
+     *
+     * A time past the newest sample gets the newest sample, this transform
+     * is never extrapolated.
+     * @return false if no sample is younger than max_age
+     */
+    bool
+    getMapTransform(NS_Transform::Transform& transform,
+                    const NS_NaviCommon::Time& time = NS_NaviCommon::Time());
+
+    /**
+     * @brief Robot pose in the map frame at time, stamped with time
+     */
+    bool
+    getRobotPose(NS_Transform::Stamped< NS_Transform::Pose >& global_pose,
+                 const NS_NaviCommon::Time& time = NS_NaviCommon::Time());
+
+    TransformStats
+    getOdomStats();
+
+    TransformStats
+    getMapStats();
+
+  private:
+    struct TransformSample
+    {
+      NS_NaviCommon::Time stamp;
+      NS_Transform::Transform transform;
+    };
+
+    struct TransformBuffer
+    {
+      TransformBuffer(const std::string& service)
+          : client(service)
+      {
+      }
+
+      NS_Service::Client< NS_ServiceType::ServiceTransform > client;
+      std::deque< TransformSample > samples; ///< Ordered by stamp, oldest first
+      TransformStats stats;
+    };
+
+    TransformCache();
+    ~TransformCache();
+
+    static void
+    createInstance();
+
+    void
+    loadParameters();
+
+    void
+    updateLoop();
+
+    /**
+     * @brief Call the service of buffer once and append the answer
+     */
+    bool
+    fetch(TransformBuffer& buffer);
+
+    /**
+     * @brief Transform of buffer at time, extrapolate false answers a time past the newest sample with the newest sample
+     */
+    bool
+    lookup(TransformBuffer& buffer, const NS_NaviCommon::Time& time,
+           bool extrapolate, NS_Transform::Transform& transform);
+
+    static NS_Transform::Transform
+    interpolate(const TransformSample& first, const TransformSample& second,
+                double ratio);
+
+  private:
+    double update_frequency_;
+    double cache_time_; ///< Seconds of history kept
+    double max_extrapolation_; ///< Seconds a lookup may reach past the newest sample
+    double max_age_; ///< Seconds after which the newest sample is too old to use
+
+    TransformBuffer odom_buffer;
+    TransformBuffer map_buffer;
+
+    boost::mutex buffer_lock;
+
+    bool running;
+    boost::thread update_thread;
+  };
+}
+
+#endif  // _COSTMAP_TRANSFORM_CACHE_H_
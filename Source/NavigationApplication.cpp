@@ -7,12 +7,13 @@
 
 #include "NavigationApplication.h"
 #include "Planner/Implements/GlobalPlanner/GlobalPlanner.h"
+#include "Planner/Implements/HierarchicalPlanner/HierarchicalPlanner.h"
 #include "Planner/Implements/TrajectoryLocalPlanner/TrajectoryLocalPlanner.h"
 #include "Planner/Implements/DwaLocalPlanner/DwaLocalPlanner.h"
 #include <Transform/DataTypes.h>
 #include <DataSet/DataType/Twist.h>
 #include <Service/ServiceType/ServiceMap.h>
-#include <Service/ServiceType/ServiceTransform.h>
+#include "CostMap/Utils/TransformCache.h"
 #include <Parameter/Parameter.h>
 
 namespace NS_Navigation
@@ -21,16 +22,19 @@ namespace NS_Navigation
   NavigationApplication::NavigationApplication()
   {
     new_goal_trigger = false;
+    new_global_plan = false;
 
     twist_pub = new NS_DataSet::Publisher< NS_DataType::Twist >("TWIST");
     goal_sub = new NS_DataSet::Subscriber< NS_DataType::PoseStamped >(
         "GOAL", boost::bind(&NavigationApplication::goalCallback, this, _1));
+    cost_to_go_srv = NULL;
   }
 
   NavigationApplication::~NavigationApplication()
   {
     delete twist_pub;
     delete goal_sub;
+    delete cost_to_go_srv;
   }
 
   void NavigationApplication::loadParameters()
@@ -48,15 +52,22 @@ namespace NS_Navigation
     planner_frequency_ = parameter.getParameter("planner_frequency", 0.0f);
     controller_frequency_ = parameter.getParameter("controller_frequency",
                                                    10.0f);
+
+    if(parameter.getParameter("replan_on_costmap_change", 1) == 1)
+      replan_on_costmap_change_ = true;
+    else
+      replan_on_costmap_change_ = false;
+
+    replan_cost_threshold_ = parameter.getParameter("replan_cost_threshold",
+                                                    50.0f);
   }
 
   bool NavigationApplication::makePlan(
       const NS_DataType::PoseStamped& goal,
       std::vector< NS_DataType::PoseStamped >& plan)
   {
-    boost::unique_lock< NS_CostMap::Costmap2D::mutex_t > lock(
-        *(global_costmap->getLayeredCostmap()->getCostmap()->getMutex()));
-
+    // the global planner works on a costmap snapshot, so the costmap lock
+    // is not held and the map keeps updating while planning
     plan.clear();
 
     //get the starting pose of the robot
@@ -89,6 +100,43 @@ namespace NS_Navigation
     return true;
   }
 
+  void NavigationApplication::costToGoService(
+      NS_ServiceType::ServiceCostToGo& srv)
+  {
+    srv.result = false;
+    srv.reachable.clear();
+    srv.costs.clear();
+    srv.paths.clear();
+
+    NS_Transform::Stamped< NS_Transform::Pose > global_pose;
+    if(!global_costmap->getRobotPose(global_pose))
+    {
+      console.error("Unable to get starting pose of robot, unable to find costs to go");
+      return;
+    }
+
+    NS_DataType::PoseStamped start;
+    NS_Transform::poseStampedTFToMsg(global_pose, start);
+
+    std::vector< NS_Planner::CostToGo > results;
+    if(!global_planner->getCostsToGo(start, srv.targets, srv.make_paths,
+                                     results))
+    {
+      console.warning("The global planner failed to find costs to go for %lu targets",
+                      (unsigned long)srv.targets.size());
+      return;
+    }
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+      srv.reachable.push_back(results[i].reachable ? 1 : 0);
+      srv.costs.push_back(results[i].cost);
+      if(srv.make_paths)
+        srv.paths.push_back(results[i].path);
+    }
+    srv.result = true;
+  }
+
   void NavigationApplication::runRecovery()
   {
 
@@ -97,6 +145,8 @@ namespace NS_Navigation
   void NavigationApplication::resetState()
   {
     state = PLANNING;
+    // plans still improving in the background are for the goal left behind
+    global_planner->cancelImprovedPlans();
     publishZeroVelocity();
   }
 
@@ -113,6 +163,7 @@ namespace NS_Navigation
             (boost::get_system_time() + boost::posix_time::milliseconds(
                 PLANNER_LOOP_TIMEOUT)));
       }
+      new_global_plan = false;
       controller_mutex.unlock();
 
       if(!running)
@@ -153,6 +204,16 @@ namespace NS_Navigation
             planning = true;
             break;
           case CONTROLLING:
+            // a replan or an improved plan replaces the one followed
+            controller_mutex.lock();
+            if(new_global_plan)
+            {
+              new_global_plan = false;
+              if(!local_planner->setPlan(*global_planner_plan))
+                console.error("Set new plan to local planner failure!");
+            }
+            controller_mutex.unlock();
+
             if(local_planner->isGoalReached())
             {
               console.message("The goal has reached!");
@@ -217,6 +278,31 @@ namespace NS_Navigation
             planner_mutex,
             (boost::get_system_time() + boost::posix_time::milliseconds(
                 PLANNER_LOOP_TIMEOUT)));
+
+        if(new_goal_trigger)
+          continue;
+
+        // plans improved in the background replace the current one, as
+        // long as it is still followed and no new goal came in meanwhile
+        planner_mutex.unlock();
+        bool improved = global_planner->getImprovedPlan(*latest_plan);
+        planner_mutex.lock();
+        if(improved && !new_goal_trigger && handOverImprovedPlan())
+          console.debug("The global planner improved the plan, %lu points to go...",
+                        (unsigned long)latest_plan->size());
+
+        if(new_goal_trigger || !replan_on_costmap_change_)
+          continue;
+
+        // replan only when the costmap changed under the current plan
+        planner_mutex.unlock();
+        bool replan = costmapChangesAffectPlan();
+        planner_mutex.lock();
+        if(replan)
+        {
+          console.message("The costmap changed on the current plan, replanning...");
+          new_goal_trigger = true;
+        }
       }
       planner_mutex.unlock();
 
@@ -228,54 +314,203 @@ namespace NS_Navigation
 
       new_goal_trigger = false;
 
-      if(!makePlan(goal, *latest_plan) && state != PLANNING)
+      // changes up to now are in the snapshot the new plan is made on
+      std::vector< NS_CostMap::DirtyRect > seen_changes;
+      global_costmap->getLayeredCostmap()->takeDirtyRects(seen_changes);
+
+      bool planned = makePlan(goal, *latest_plan);
+      if(!planned && new_goal_trigger)
+      {
+        // the search was given up for the goal that came in meanwhile
+        console.message("A new goal arrived while planning, planning for it...");
+        continue;
+      }
+
+      if(!planned && state != PLANNING)
       {
         console.error("Make plan failure!");
         continue;
       }
 
-      controller_mutex.lock();
-      state = CONTROLLING;
-      global_planner_plan->clear();
-      global_planner_plan->assign(latest_plan->begin(), latest_plan->end());
-      controller_cond.notify_one();
-      controller_mutex.unlock();
+      handOverPlan();
 
       if(planner_frequency_ != 0.0f)
         rate.sleep();
     }
   }
 
+  bool NavigationApplication::planPreempted()
+  {
+    return new_goal_trigger;
+  }
+
+  void NavigationApplication::handOverPlan()
+  {
+    controller_mutex.lock();
+    state = CONTROLLING;
+    global_planner_plan->clear();
+    global_planner_plan->assign(latest_plan->begin(), latest_plan->end());
+    recordPlanCosts();
+    new_global_plan = true;
+    controller_cond.notify_one();
+    controller_mutex.unlock();
+  }
+
+  bool NavigationApplication::handOverImprovedPlan()
+  {
+    boost::mutex::scoped_lock lock(controller_mutex);
+    // the goal was reached or given up, or a plan for a new one is coming
+    if(state != CONTROLLING)
+      return false;
+
+    global_planner_plan->clear();
+    global_planner_plan->assign(latest_plan->begin(), latest_plan->end());
+    recordPlanCosts();
+    new_global_plan = true;
+    controller_cond.notify_one();
+    return true;
+  }
+
+  void NavigationApplication::recordPlanCosts()
+  {
+    NS_CostMap::CostmapSnapshotPtr snapshot = global_costmap->getSnapshot();
+    const NS_CostMap::Costmap2D& costmap = snapshot->getCostmap();
+
+    plan_costs.assign(global_planner_plan->size(), NS_CostMap::FREE_SPACE);
+    for(size_t i = 0; i < global_planner_plan->size(); i++)
+    {
+      const NS_DataType::Point& position = (*global_planner_plan)[i].pose.position;
+      unsigned int mx, my;
+      if(costmap.worldToMap(position.x, position.y, mx, my))
+        plan_costs[i] = costmap.getCost(mx, my);
+    }
+
+    // the cells between the poses of sparse plans, in the order
+    // costmapChangesAffectPlan() samples them
+    plan_sample_costs.clear();
+    double resolution = costmap.getResolution();
+    for(size_t i = 1; i < global_planner_plan->size(); i++)
+    {
+      const NS_DataType::Point& from = (*global_planner_plan)[i - 1].pose.position;
+      const NS_DataType::Point& to = (*global_planner_plan)[i].pose.position;
+      int samples = (int)(hypot(to.x - from.x, to.y - from.y) / resolution);
+      for(int k = 1; k < samples; k++)
+      {
+        double x = from.x + (to.x - from.x) * k / samples;
+        double y = from.y + (to.y - from.y) * k / samples;
+        unsigned int mx, my;
+        if(costmap.worldToMap(x, y, mx, my))
+          plan_sample_costs.push_back(costmap.getCost(mx, my));
+        else
+          plan_sample_costs.push_back(NS_CostMap::FREE_SPACE);
+      }
+    }
+  }
+
+  bool NavigationApplication::costmapChangesAffectPlan()
+  {
+    std::vector< NS_CostMap::DirtyRect > changes;
+    global_costmap->getLayeredCostmap()->takeDirtyRects(changes);
+    if(changes.empty())
+      return false;
+
+    NS_CostMap::CostmapSnapshotPtr snapshot = global_costmap->getSnapshot();
+    const NS_CostMap::Costmap2D& costmap = snapshot->getCostmap();
+
+    boost::mutex::scoped_lock lock(controller_mutex);
+    if(state != CONTROLLING || global_planner_plan->empty() || plan_costs.size() != global_planner_plan->size())
+      return false;
+
+    // only the plan poses inside a changed area are looked at
+    int changed_poses = 0;
+    double cost_increase = 0.0;
+    for(size_t i = 0; i < global_planner_plan->size(); i++)
+    {
+      const NS_DataType::Point& position = (*global_planner_plan)[i].pose.position;
+
+      bool changed = false;
+      for(size_t r = 0; r < changes.size() && !changed; r++)
+        changed = changes[r].contains(position.x, position.y);
+      if(!changed)
+        continue;
+
+      unsigned int mx, my;
+      if(!costmap.worldToMap(position.x, position.y, mx, my))
+        continue;
+
+      // a pose that was blocked already when the plan was made, such as
+      // the robot's own cell, does not call for a new plan
+      unsigned char cost = costmap.getCost(mx, my);
+      if(isBlocked(cost))
+      {
+        if(!isBlocked(plan_costs[i]))
+          return true;
+        continue;
+      }
+
+      if(cost == NS_CostMap::NO_INFORMATION)
+        continue;
+
+      changed_poses++;
+      cost_increase += (double)cost - plan_costs[i];
+    }
+
+    // poses of sparse plans are far apart, the cells between them must not
+    // have become lethal either
+    double resolution = costmap.getResolution();
+    size_t sample = 0;
+    for(size_t i = 1; i < global_planner_plan->size(); i++)
+    {
+      const NS_DataType::Point& from = (*global_planner_plan)[i - 1].pose.position;
+      const NS_DataType::Point& to = (*global_planner_plan)[i].pose.position;
+      int samples = (int)(hypot(to.x - from.x, to.y - from.y) / resolution);
+      for(int k = 1; k < samples; k++, sample++)
+      {
+        double x = from.x + (to.x - from.x) * k / samples;
+        double y = from.y + (to.y - from.y) * k / samples;
+
+        bool changed = false;
+        for(size_t r = 0; r < changes.size() && !changed; r++)
+          changed = changes[r].contains(x, y);
+
+        unsigned int mx, my;
+        if(!changed || !costmap.worldToMap(x, y, mx, my))
+          continue;
+
+        // samples past the recorded ones, after a change of resolution,
+        // count as free when the plan was made
+        bool was_blocked = sample < plan_sample_costs.size() && isBlocked(plan_sample_costs[sample]);
+        if(isBlocked(costmap.getCost(mx, my)) && !was_blocked)
+          return true;
+      }
+    }
+
+    return changed_poses > 0 && cost_increase / changed_poses > replan_cost_threshold_;
+  }
+
   NS_DataType::PoseStamped NavigationApplication::goalToGlobalFrame(
       NS_DataType::PoseStamped& goal)
   {
     NS_Transform::Stamped< NS_Transform::Pose > goal_pose, global_pose;
     poseStampedMsgToTF(goal, goal_pose);
 
-    NS_Service::Client< NS_ServiceType::ServiceTransform > odom_tf_cli(
-        "BASE_ODOM_TF");
-    NS_Service::Client< NS_ServiceType::ServiceTransform > map_tf_cli(
-        "ODOM_MAP_TF");
-    NS_ServiceType::ServiceTransform odom_transform;
-    NS_ServiceType::ServiceTransform map_transform;
+    NS_CostMap::TransformCache& transform_cache =
+        NS_CostMap::TransformCache::getInstance();
+    NS_Transform::Transform odom_tf, map_tf;
 
-    if(odom_tf_cli.call(odom_transform) == false)
+    if(!transform_cache.getOdomTransform(odom_tf))
     {
       console.warning("Get odometry transform failure!");
       return goal;
     }
 
-    if(map_tf_cli.call(map_transform) == false)
+    if(!transform_cache.getMapTransform(map_tf))
     {
       console.warning("Get map transform failure!");
       return goal;
     }
 
     //TODO: not verify code for transform
-    NS_Transform::Transform odom_tf, map_tf;
-    NS_Transform::transformMsgToTF(odom_transform.transform, odom_tf);
-    NS_Transform::transformMsgToTF(map_transform.transform, map_tf);
-
     global_pose.setData(odom_tf * map_tf * goal_pose);
 
     NS_DataType::PoseStamped global_pose_data;
@@ -367,6 +602,9 @@ namespace NS_Navigation
   {
     loadParameters();
 
+    // poll the transform services before anything asks for the robot pose
+    NS_CostMap::TransformCache::getInstance().start();
+
     //set up plan triple buffer
     global_planner_plan = new std::vector< NS_DataType::PoseStamped >();
     latest_plan = new std::vector< NS_DataType::PoseStamped >();
@@ -382,17 +620,27 @@ namespace NS_Navigation
     {
       global_planner = new NS_Planner::GlobalPlanner();
     }
+    else if(global_planner_type_ == "hierarchical_planner")
+    {
+      global_planner = new NS_Planner::HierarchicalPlanner();
+    }
     else
     {
       global_planner = new NS_Planner::GlobalPlanner();
     }
 
     global_planner->initialize(global_costmap);
+    global_planner->setPreemptCheck(
+        boost::bind(&NavigationApplication::planPreempted, this));
+
+    cost_to_go_srv = new NS_Service::Server< NS_ServiceType::ServiceCostToGo >(
+        "COST_TO_GO",
+        boost::bind(&NavigationApplication::costToGoService, this, _1));
 
     /*
      * make local planner and local costmap
      */
-    local_costmap = new NS_CostMap::CostmapWrapper();
+    local_costmap = new NS_CostMap::CostmapWrapper("local_costmap.xml", true);
     local_costmap->initialize();
 
     //load local planner
@@ -409,7 +657,7 @@ namespace NS_Navigation
       local_planner = new NS_Planner::TrajectoryLocalPlanner();
     }
 
-    local_planner->initialize(global_costmap);
+    local_planner->initialize(local_costmap);
 
     state = PLANNING;
 
@@ -448,6 +696,8 @@ namespace NS_Navigation
 
     running = false;
     plan_thread.join();
+
+    NS_CostMap::TransformCache::getInstance().stop();
   }
 
 } /* namespace NS_Navigation */
@@ -20,6 +20,8 @@
 #include <vector>
 #include <DataSet/Publisher.h>
 #include <DataSet/Subscriber.h>
+#include <Service/Server.h>
+#include "Planner/Base/ServiceCostToGo.h"
 
 namespace NS_Navigation
 {
@@ -56,6 +58,12 @@ namespace NS_Navigation
     void
     goalCallback(NS_DataType::PoseStamped& target_goal);
 
+    /**
+     * @brief Answer a batch cost-to-go query from the robot pose with the global planner
+     */
+    void
+    costToGoService(NS_ServiceType::ServiceCostToGo& srv);
+
     NS_DataType::PoseStamped
     goalToGlobalFrame(NS_DataType::PoseStamped& goal);
 
@@ -76,6 +84,48 @@ namespace NS_Navigation
 
     void
     resetState();
+
+    /**
+     * @brief Hand latest_plan over to the controller as global_planner_plan
+     */
+    void
+    handOverPlan();
+
+    /**
+     * @brief Hand latest_plan over as an improvement of the plan followed
+     * @return False if the controller is no longer following a plan to this goal, the plan is dropped then
+     */
+    bool
+    handOverImprovedPlan();
+
+    /**
+     * @brief True once a new goal waits, the global planner gives up the plan it is making then
+     *
+     * Called by the global planner with its own lock held, so planner_mutex is not taken.
+     */
+    bool
+    planPreempted();
+
+    /**
+     * @brief Cost of every pose of global_planner_plan and of the cells between them in the latest global costmap, call with controller_mutex held
+     */
+    void
+    recordPlanCosts();
+
+    /**
+     * @brief Check the current plan against the global costmap areas updated since the last check
+     * @return True if a changed area blocks the plan or raised its cost above replan_cost_threshold_
+     */
+    bool
+    costmapChangesAffectPlan();
+
+    /**
+     * @brief True if the robot can not pass a cell of this cost
+     */
+    static bool isBlocked(unsigned char cost)
+    {
+      return cost == NS_CostMap::LETHAL_OBSTACLE || cost == NS_CostMap::INSCRIBED_INFLATED_OBSTACLE;
+    }
   private:
     std::string global_planner_type_;
     std::string local_planner_type_;
@@ -87,11 +137,16 @@ namespace NS_Navigation
     bool shutdown_costmaps_, clearing_rotation_allowed_,
         recovery_behavior_enabled_;
     double oscillation_timeout_, oscillation_distance_;
+    bool replan_on_costmap_change_;
+    double replan_cost_threshold_; ///< Mean cost increase of the changed plan poses that triggers a replan
 
   private:
     //set up plan triple buffer
     std::vector< NS_DataType::PoseStamped >* global_planner_plan;
     std::vector< NS_DataType::PoseStamped >* latest_plan;
+    std::vector< unsigned char > plan_costs; ///< Costs along global_planner_plan when it was made
+    std::vector< unsigned char > plan_sample_costs; ///< Costs of the cells sampled between the poses of global_planner_plan when it was made
+    bool new_global_plan; ///< global_planner_plan changed since the local planner was given it, guarded by controller_mutex
 
     NS_DataType::PoseStamped oscillation_pose_;
 
@@ -105,7 +160,7 @@ namespace NS_Navigation
 
     NS_DataType::PoseStamped goal;
 
-    bool new_goal_trigger;
+    volatile bool new_goal_trigger; ///< Written under planner_mutex, read without it by planPreempted()
 
     boost::thread plan_thread;
     boost::mutex planner_mutex;
@@ -119,6 +174,7 @@ namespace NS_Navigation
 
     NS_DataSet::Publisher< NS_DataType::Twist >* twist_pub;
     NS_DataSet::Subscriber< NS_DataType::PoseStamped >* goal_sub;
+    NS_Service::Server< NS_ServiceType::ServiceCostToGo >* cost_to_go_srv;
 
   public:
     virtual void
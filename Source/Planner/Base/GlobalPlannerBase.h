@@ -11,9 +11,28 @@
 #include <DataSet/DataType/PoseStamped.h>
 #include "../../CostMap/CostmapWrapper.h"
 
+#include <boost/function.hpp>
+
 namespace NS_Planner
 {
 
+  /**
+   * @class CostToGo
+   * @brief Result of a batch query for one target
+   */
+  class CostToGo
+  {
+  public:
+    CostToGo()
+        : reachable(false), cost(0)
+    {
+    }
+
+    bool reachable;
+    double cost; ///< Potential of the target, neutral_cost per cell of free space
+    std::vector< NS_DataType::PoseStamped > path; ///< Only filled in if paths were asked for
+  };
+
   class GlobalPlannerBase
   {
   public:
@@ -51,8 +70,50 @@ namespace NS_Planner
       makePlan(start, goal, plan);
     }
     ;
+
+    /**
+     * @brief Cost from start to each of targets, over a single search where the planner supports it
+     * @param make_paths Extract the path to every reachable target too
+     * @return False if the planner does not support batch queries or start is off the map
+     */
+    virtual bool
+    getCostsToGo(const NS_DataType::PoseStamped& start,
+                 const std::vector< NS_DataType::PoseStamped >& targets,
+                 bool make_paths, std::vector< CostToGo >& results)
+    {
+      results.clear();
+      return false;
+    }
+
+    /**
+     * @brief Take a plan found in the background since makePlan() returned, better than the last one handed out
+     * @return False if there is none, which is always the case unless the planner improves plans over time
+     */
+    virtual bool
+    getImprovedPlan(std::vector< NS_DataType::PoseStamped >& plan)
+    {
+      return false;
+    }
+
+    /**
+     * @brief Drop the plans improved in the background and stop improving, once the goal is reached or given up
+     */
+    virtual void
+    cancelImprovedPlans()
+    {
+    }
+
+    /**
+     * @brief Give up a running search once check returns true, looked at between slices by planners that search in slices
+     */
+    void setPreemptCheck(const boost::function< bool() >& check)
+    {
+      preempt_check = check;
+    }
+
   protected:
     NS_CostMap::CostmapWrapper* costmap;
+    boost::function< bool() > preempt_check; ///< Empty unless set, a new goal arrived while planning
   };
 
 } /* namespace NS_Planner */
@@ -20,6 +20,7 @@ namespace NS_Planner
   {
   public:
     LocalPlannerBase()
+        : costmap(NULL), costmap_version(0)
     {
     }
     ;
@@ -32,6 +33,16 @@ namespace NS_Planner
     void initialize(NS_CostMap::CostmapWrapper* costmap_)
     {
       costmap = costmap_;
+
+      // start from the live map so the planner can size its grids, later
+      // cycles only read published snapshots
+      {
+        boost::unique_lock< NS_CostMap::Costmap2D::mutex_t > lock(
+            *(costmap->getCostmap()->getMutex()));
+        costmap_copy = *costmap->getCostmap();
+      }
+      costmap_version = 0;
+
       onInitialize();
     }
     ;
@@ -49,7 +60,23 @@ namespace NS_Planner
     setPlan(const std::vector< NS_DataType::PoseStamped >& plan) = 0;
 
   protected:
+    /**
+     * @brief Refresh costmap_copy from the latest costmap snapshot if a newer one was published
+     */
+    void updateCostmapCopy()
+    {
+      NS_CostMap::CostmapSnapshotPtr snapshot = costmap->getSnapshot();
+      if(snapshot->getVersion() == 0 || snapshot->getVersion() == costmap_version)
+        return;
+
+      costmap_copy = snapshot->getCostmap();
+      costmap_version = snapshot->getVersion();
+    }
+
     NS_CostMap::CostmapWrapper* costmap;
+
+    NS_CostMap::Costmap2D costmap_copy; ///< The costmap the controller reads, refreshed by updateCostmapCopy() without blocking the costmap update
+    unsigned long costmap_version; ///< Version of the snapshot held in costmap_copy
   };
 
 } /* namespace NS_Planner */
@@ -0,0 +1,38 @@
+/*
+ * ServiceCostToGo.h
+ *
+ * Batch cost-to-go query, answered by NavigationApplication as
+ * "COST_TO_GO" from a single search of the global planner.
+ */
+
+#ifndef _SERVICE_COST_TO_GO_H_
+#define _SERVICE_COST_TO_GO_H_
+
+#include <vector>
+#include <DataSet/DataType/PoseStamped.h>
+#include <Service/ServiceType/ServiceBase.h>
+
+namespace NS_ServiceType
+{
+
+  class ServiceCostToGo: public ServiceBase
+  {
+  public:
+    ServiceCostToGo()
+        : make_paths(false)
+    {
+    }
+
+    // request
+    std::vector< NS_DataType::PoseStamped > targets; ///< Points in the global costmap frame
+    bool make_paths; ///< Also return the path to every reachable target
+
+    // response, one entry per target, result is false if nothing was searched
+    std::vector< int > reachable; ///< 1 if a path to the target exists
+    std::vector< double > costs; ///< Cost to go from the robot, neutral_cost per cell of free space
+    std::vector< std::vector< NS_DataType::PoseStamped > > paths; ///< Empty unless make_paths
+  };
+
+} /* namespace NS_ServiceType */
+
+#endif
@@ -56,7 +56,7 @@ namespace NS_Planner
       costmap->getRobotPose(current_pose_);
 
       // make sure to update the costmap we'll use for this cycle
-      NS_CostMap::Costmap2D* costmap2d = costmap->getCostmap();
+      NS_CostMap::Costmap2D* costmap2d = &costmap_copy;
 
       planner_util_.initialize(costmap2d);
 
@@ -164,6 +164,8 @@ namespace NS_Planner
       return false;
     }
 
+    odom_helper_.updateOdom();
+
     if(latchedStopRotateController_->isGoalReached(&planner_util_, odom_helper_,
                                                    current_pose_))
     {
@@ -253,6 +255,11 @@ namespace NS_Planner
 
   bool DwaLocalPlanner::computeVelocityCommands(NS_DataType::Twist& cmd_vel)
   {
+    updateCostmapCopy();
+
+    // one odometry sample for the whole cycle
+    odom_helper_.updateOdom();
+
     // dispatches to either dwa sampling control or stop and rotate control, depending on whether we have been close enough to goal
     if(!costmap->getRobotPose(current_pose_))
     {
@@ -1,76 +1,137 @@
 #include "Astar.h"
-#include "../../../../CostMap/CostMap2D/CostValues.h"
 
 namespace NS_Planner
 {
 
   AStarExpansion::AStarExpansion(PotentialCalculator* p_calc, int xs, int ys)
-      : Expander(p_calc, xs, ys)
+      : Expander(p_calc, xs, ys), closed_(NULL), closed_generation_(0),
+        goal_x_(0), goal_y_(0), goal_i_(0), weight_(1.0), landmarks_(NULL),
+        search_costs_(NULL), search_potential_(NULL), cycle_(0), cycles_(0),
+        max_queue_(0), queue_growths_(0)
   {
   }
 
+  ExpansionStats AStarExpansion::getStats()
+  {
+    ExpansionStats stats;
+    stats.cells_visited = cells_visited_;
+    stats.max_queue = max_queue_;
+    stats.queue_growths = queue_growths_;
+    return stats;
+  }
+
   bool AStarExpansion::calculatePotentials(unsigned char* costs, double start_x,
                                            double start_y, double end_x,
                                            double end_y, int cycles,
                                            float* potential)
   {
+    SearchState state = startSearch(costs, start_x, start_y, end_x, end_y,
+                                    cycles, potential);
+    while(state == SEARCH_IN_PROGRESS)
+      state = resumeSearch();
+    return state == SEARCH_FOUND;
+  }
 
-    queue_.clear();
+  Expander::SearchState AStarExpansion::startSearch(unsigned char* costs,
+                                                    double start_x,
+                                                    double start_y,
+                                                    double end_x, double end_y,
+                                                    int cycles,
+                                                    float* potential)
+  {
+    cells_visited_ = 0;
+    max_queue_ = queue_growths_ = 0;
 
-    int start_i = toIndex(start_x, start_y);
+    // a cell is open while its potential is set and it is not closed, the
+    // heap positions are only read for open cells so they are never cleared
+    queue_.reset(workspace_->getCellIndex());
+    closed_ = workspace_->getMarks();
+    closed_generation_ = workspace_->nextGeneration();
 
-    queue_.push_back(Index(start_i, 0));
+    // any cell may be written, the next search clears them all
+    workspace_->resetPotential(potential);
+    workspace_->markPotential(potential, 0, ns_);
 
-    std::fill(potential, potential + ns_, POT_HIGH);
+    goal_x_ = (int)end_x;
+    goal_y_ = (int)end_y;
+    goal_i_ = toIndex(end_x, end_y);
 
+    table_.reset();
+    if(landmarks_ != NULL)
+    {
+      table_ = landmarks_->getTable();
+      if(table_ && (table_->getSizeX() != nx_ || table_->getSizeY() != ny_))
+        table_.reset();
+    }
+
+    int start_i = toIndex(start_x, start_y);
     potential[start_i] = 0;
+    queue_.push(start_i, heuristic(start_i));
+
+    search_costs_ = costs;
+    search_potential_ = potential;
+    cycle_ = 0;
+    cycles_ = cycles;
+    return resumeSearch();
+  }
 
-    int goal_i = toIndex(end_x, end_y);
-    int cycle = 0;
+  Expander::SearchState AStarExpansion::resumeSearch()
+  {
+    unsigned char* costs = search_costs_;
+    float* potential = search_potential_;
 
-    while(queue_.size() > 0 && cycle < cycles)
+    startSlice();
+    for(; !queue_.empty() && cycle_ < cycles_; cycle_++)
     {
-      Index top = queue_[0];
+      if(sliceOver())
+        return SEARCH_IN_PROGRESS;
+
+      if(queue_.size() > max_queue_)
+        max_queue_ = queue_.size();
 
-      std::pop_heap(queue_.begin(), queue_.end(), greater1());
-      queue_.pop_back();
+      int i = queue_.pop();
+      closed_[i] = closed_generation_;
+      cells_visited_++;
 
-      int i = top.i;
-      if(i == goal_i)
-        return true;
+      if(i == goal_i_)
+        return SEARCH_FOUND;
 
-      add(costs, potential, potential[i], i + 1, end_x, end_y);
-      add(costs, potential, potential[i], i - 1, end_x, end_y);
-      add(costs, potential, potential[i], i + nx_, end_x, end_y);
-      add(costs, potential, potential[i], i - nx_, end_x, end_y);
+      add(costs, potential, i + 1);
+      add(costs, potential, i - 1);
+      add(costs, potential, i + nx_);
+      add(costs, potential, i - nx_);
     }
 
-    return false;
+    return SEARCH_FAILED;
   }
 
-  /* to DISCUSS */
-  void AStarExpansion::add(unsigned char* costs, float* potential,
-                           float prev_potential, int next_i, int end_x,
-                           int end_y)
+  void AStarExpansion::add(unsigned char* costs, float* potential, int next_i)
   {
-    if(potential[next_i] < POT_HIGH)
+    if(next_i < 0 || next_i >= ns_ || closed_[next_i] == closed_generation_)
+      return;
+
+    float c = getCost(costs, next_i);
+    if(c >= lethal_cost_)
       return;
 
-    if(costs[next_i] >= lethal_cost_ && !(unknown_ && costs[next_i] == NS_CostMap::NO_INFORMATION))
+    // the calculator takes the lowest neighbors, which includes the cell
+    // just closed, so open cells settle between their expanded neighbors
+    float pot = p_calc_->calculatePotential(potential, c, next_i);
+    if(pot >= potential[next_i])
       return;
 
-    potential[next_i] = p_calc_->calculatePotential(
-        potential, costs[next_i] + neutral_cost_, next_i, prev_potential);
-    int x = next_i % nx_, y = next_i / nx_;
-    float distance = abs(end_x - x) + abs(end_y - y);
-
-    /*
-     * Given a heap in the range [first,last-1), this function extends the range considered a heap to [first,last) by
-     * placing the value in (last-1) into its corresponding location within it.
-     */
-    queue_.push_back(
-        Index(next_i, potential[next_i] + distance * neutral_cost_));
-    std::push_heap(queue_.begin(), queue_.end(), greater1());
+    if(potential[next_i] < POT_HIGH)
+    {
+      // already open, only its potential went down
+      potential[next_i] = pot;
+      queue_.decrease(next_i, pot + heuristic(next_i));
+      return;
+    }
+
+    potential[next_i] = pot;
+    if(queue_.size() == queue_.capacity())
+      queue_growths_++;
+    queue_.push(next_i, pot + heuristic(next_i));
   }
 
 } //end namespace global_planner
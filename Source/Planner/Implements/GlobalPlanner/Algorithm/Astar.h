@@ -2,32 +2,24 @@
 #define _ASTAR_H_
 
 #include "Expander.h"
-#include <vector>
-#include <algorithm>
+#include "IndexedHeap.h"
+#include "Landmarks.h"
 
 namespace NS_Planner
 {
 
-  class Index
-  {
-  public:
-    Index(int a, float b)
-    {
-      i = a;
-      cost = b;
-    }
-    int i;
-    float cost;
-  };
-
-  struct greater1
-  {
-    bool operator()(const Index& a, const Index& b) const
-    {
-      return a.cost > b.cost;
-    }
-  };
-
+  /**
+   * @class AStarExpansion
+   * @brief Best first expansion from start towards the goal
+   *
+   * Cells are expanded once, in order of potential plus the weighted
+   * distance to the goal. The distance is the least potential the
+   * PotentialCalculator propagates at the lowest cell cost, so with a weight
+   * of 1 the heuristic never overestimates and the path is as short as the
+   * one Dijkstra finds. With landmark tables of the static map, the bound
+   * from them is taken where it is higher, which guides the search around
+   * walls and keeps it out of dead ends.
+   */
   class AStarExpansion: public Expander
   {
   public:
@@ -37,14 +29,58 @@ namespace NS_Planner
     calculatePotentials(unsigned char* costs, double start_x, double start_y,
                         double end_x, double end_y, int cycles,
                         float* potential);
+
+    SearchState
+    startSearch(unsigned char* costs, double start_x, double start_y,
+                double end_x, double end_y, int cycles, float* potential);
+
+    SearchState
+    resumeSearch();
+
+    /**
+     * @brief Scale the heuristic by weight, above 1 fewer cells are expanded and the path may be longer by up to that factor
+     */
+    void setWeight(float weight)
+    {
+      weight_ = weight < 1.0 ? 1.0 : weight;
+    }
+
+    /**
+     * @brief Take the tables of landmarks too, if it has one for the map size when a search starts
+     */
+    void setLandmarks(LandmarkHeuristic* landmarks)
+    {
+      landmarks_ = landmarks;
+    }
+
+    ExpansionStats
+    getStats();
   private:
     void
-    add(unsigned char* costs, float* potential, float prev_potential,
-        int next_i, int end_x, int end_y);
+    add(unsigned char* costs, float* potential, int next_i);
+
+    inline float heuristic(int i)
+    {
+      float h = neutral_cost_ * p_calc_->unitDistance(i % nx_ - goal_x_, i / nx_ - goal_y_);
+      if(table_)
+        h = std::max(h, table_->lowerBound(i, goal_i_));
+      return weight_ * h;
+    }
+
+    IndexedHeap queue_; /**< open cells keyed by potential plus heuristic */
+    unsigned int* closed_; /**< expanded cells, stamped with closed_generation_ */
+    unsigned int closed_generation_;
+    int goal_x_, goal_y_, goal_i_;
+    float weight_;
+    LandmarkHeuristic* landmarks_;
+    LandmarkTablePtr table_; /**< landmark tables of the running search, empty if there are none */
+    unsigned char* search_costs_; /**< search kept between slices */
+    float* search_potential_;
+    int cycle_, cycles_;
 
-    std::vector< Index > queue_;
+    unsigned long max_queue_;
+    unsigned long queue_growths_;
   };
 
 } //end namespace global_planner
 #endif
-
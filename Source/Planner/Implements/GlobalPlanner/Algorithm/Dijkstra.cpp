@@ -1,5 +1,6 @@
 #include "Dijkstra.h"
 #include <algorithm>
+#include <boost/bind.hpp>
 
 #include <Console/Console.h>
 
@@ -8,36 +9,59 @@ namespace NS_Planner
 
   DijkstraExpansion::DijkstraExpansion(PotentialCalculator* p_calc, int nx,
                                        int ny)
-      : Expander(p_calc, nx, ny), pending_(NULL), precise_(false)
+      : Expander(p_calc, nx, ny), pending_(NULL), pending_generation_(0),
+        precise_(false), expand_all_(false), batch_(false),
+        touched_begin_(0), touched_end_(0), threads_(1),
+        parallel_block_cells_(DEFAULT_PARALLEL_BLOCK_CELLS),
+        barrier_(NULL), stop_workers_(false), block_costs_(NULL),
+        block_potential_(NULL), search_costs_(NULL), search_potential_(NULL),
+        start_cell_(0), cycle_(0), cycles_(0)
   {
-    // priority buffers
-    buffer1_ = new int[PRIORITYBUFSIZE];
-    buffer2_ = new int[PRIORITYBUFSIZE];
-    buffer3_ = new int[PRIORITYBUFSIZE];
+    current_level_ = 0;
+    queued_ = max_queue_ = queue_growths_ = 0;
 
     priorityIncrement_ = 2 * neutral_cost_;
   }
 
   DijkstraExpansion::~DijkstraExpansion()
   {
-    delete[] buffer1_;
-    delete[] buffer2_;
-    delete[] buffer3_;
-    if(pending_)
-      delete[] pending_;
+    stopWorkers();
   }
 
-//
-// Set/Reset map size
-//
-  void DijkstraExpansion::setSize(int xs, int ys)
+  void DijkstraExpansion::setThreads(int threads)
   {
-    Expander::setSize(xs, ys);
-    if(pending_)
-      delete[] pending_;
+    stopWorkers();
+    threads_ = std::max(threads, 1);
+    found_.resize(threads_);
+    if(threads_ == 1)
+      return;
 
-    pending_ = new bool[ns_]; // ns_ = nx_ * ny_   protected
-    memset(pending_, 0, ns_ * sizeof(bool));
+    barrier_ = new boost::barrier(threads_);
+    for(int i = 1; i < threads_; i++)
+      workers_.create_thread(boost::bind(&DijkstraExpansion::runWorker, this, i));
+  }
+
+  void DijkstraExpansion::stopWorkers()
+  {
+    if(barrier_ == NULL)
+      return;
+
+    stop_workers_ = true;
+    barrier_->wait();
+    workers_.join_all();
+    stop_workers_ = false;
+
+    delete barrier_;
+    barrier_ = NULL;
+  }
+
+  ExpansionStats DijkstraExpansion::getStats()
+  {
+    ExpansionStats stats;
+    stats.cells_visited = cells_visited_;
+    stats.max_queue = max_queue_;
+    stats.queue_growths = queue_growths_;
+    return stats;
   }
 
 //
@@ -53,25 +77,45 @@ namespace NS_Planner
                                               double end_x, double end_y,
                                               int cycles, float* potential)
   {
+    SearchState state = startSearch(costs, start_x, start_y, end_x, end_y,
+                                    cycles, potential);
+    while(state == SEARCH_IN_PROGRESS)
+      state = resumeSearch();
+    return state == SEARCH_FOUND;
+  }
 
-    printf("calculatePotentials running...\n");
-
+  Expander::SearchState DijkstraExpansion::startSearch(unsigned char* costs,
+                                                       double start_x,
+                                                       double start_y,
+                                                       double end_x,
+                                                       double end_y, int cycles,
+                                                       float* potential)
+  {
     cells_visited_ = 0;
-    // priority buffers
-    threshold_ = lethal_cost_;
-    currentBuffer_ = buffer1_;
-    currentEnd_ = 0;
-    nextBuffer_ = buffer2_;
-    nextEnd_ = 0;
-    overBuffer_ = buffer3_;
-    overEnd_ = 0;
-
-    memset(pending_, 0, ns_ * sizeof(bool));
+    queued_ = max_queue_ = queue_growths_ = 0;
 
-    std::fill(potential, potential + ns_, POT_HIGH);
+    // priority buckets, one level more than a single update can jump ahead
+    threshold_ = lethal_cost_;
+    unsigned int level_count = 2 + (unsigned int)(lethal_cost_ / priorityIncrement_);
+    if(levels_.size() != level_count)
+      levels_.resize(level_count);
+    for(unsigned int i = 0; i < levels_.size(); i++)
+      levels_[i].clear();
+    current_level_ = 0;
+    current_.clear();
+    next_.clear();
+
+    // a new generation leaves every cell not pending without touching the map
+    pending_ = workspace_->getMarks();
+    pending_generation_ = workspace_->nextGeneration();
+
+    // only the rows earlier searches wrote are cleared
+    workspace_->resetPotential(potential);
 
     // set goal
     int k = toIndex(start_x, start_y);
+    touched_begin_ = k;
+    touched_end_ = precise_ ? k + nx_ + 2 : k + 1;
 
     if(precise_)
     {
@@ -83,87 +127,287 @@ namespace NS_Planner
       potential[k + nx_] = neutral_cost_ * 2 * dx * (1 - dy);
       potential[k + nx_ + 1] = neutral_cost_ * 2 * (1 - dx) * (1 - dy); //*/
 
-      push_cur(k + 2);
-      push_cur(k - 1);
-      push_cur(k + nx_ - 1);
-      push_cur(k + nx_ + 2);
+      push(current_, costs, k + 2);
+      push(current_, costs, k - 1);
+      push(current_, costs, k + nx_ - 1);
+      push(current_, costs, k + nx_ + 2);
 
-      push_cur(k - nx_);
-      push_cur(k - nx_ + 1);
-      push_cur(k + nx_ * 2);
-      push_cur(k + nx_ * 2 + 1);
+      push(current_, costs, k - nx_);
+      push(current_, costs, k - nx_ + 1);
+      push(current_, costs, k + nx_ * 2);
+      push(current_, costs, k + nx_ * 2 + 1);
     }
     else
     {
       potential[k] = 0;
-      push_cur(k + 1);
-      push_cur(k - 1);
-      push_cur(k - nx_);
-      push_cur(k + nx_);
+      push(current_, costs, k + 1);
+      push(current_, costs, k - 1);
+      push(current_, costs, k - nx_);
+      push(current_, costs, k + nx_);
     }
 
-    int nwv = 0;            // max priority block size
-    int nc = 0;            // number of cells put into priority blocks
-    int cycle = 0;        // which cycle we're on
+    // the queues above are kept until the search is done, with these
+    search_costs_ = costs;
+    search_potential_ = potential;
+    cycle_ = 0;        // which cycle we're on
+    cycles_ = cycles;
 
     // set up start cell
-    int startCell = toIndex(end_x, end_y);
+    start_cell_ = toIndex(end_x, end_y);
 
-    printf("Beforing for loop...\n");
+    return resumeSearch();
+  }
 
-    for(; cycle < cycles; cycle++) // go for this many cycles, unless interrupted
+  Expander::SearchState DijkstraExpansion::resumeSearch()
+  {
+    unsigned char* costs = search_costs_;
+    float* potential = search_potential_;
+
+    startSlice();
+    for(; cycle_ < cycles_; cycle_++) // go for this many cycles, unless interrupted
     {
-      // 
-      if(currentEnd_ == 0 && nextEnd_ == 0) // priority blocks empty
-        return false;
+      // blocks are small, the slice ends between two of them
+      if(sliceOver())
+        return markTouched(SEARCH_IN_PROGRESS);
 
-      // stats
-      nc += currentEnd_;
-      if(currentEnd_ > nwv)
-        nwv = currentEnd_;
+      // move up to the next non-empty level
+      unsigned int skipped = 0;
+      while(current_.empty() && next_.empty() && skipped < levels_.size())
+      {
+        threshold_ += priorityIncrement_;    // increment priority threshold
+        current_level_ = (current_level_ + 1) % levels_.size();
+        current_.swap(levels_[current_level_]);
+        skipped++;
+      }
+      if(current_.empty() && next_.empty()) // priority blocks empty
+        return markTouched(expand_all_ || batch_ ? SEARCH_FOUND : SEARCH_FAILED);
+
+      if(current_.empty())
+        current_.swap(next_);
 
-      // reset pending_ flags on current priority buffer
-      int *pb = currentBuffer_;
-      int i = currentEnd_;
-      while(i-- > 0)
-        pending_[*(pb++)] = false;
+      // stats
+      unsigned long waiting = queued_ - cells_visited_;
+      if(waiting > max_queue_)
+        max_queue_ = waiting;
 
       // process current priority buffer
-      pb = currentBuffer_;
-      i = currentEnd_;
-      while(i-- > 0)
-        updateCell(costs, potential, *pb++);
-
-      // swap priority blocks currentBuffer_ <=> nextBuffer_
-      currentEnd_ = nextEnd_;
-      nextEnd_ = 0;
-      pb = currentBuffer_;        // swap buffers
-      currentBuffer_ = nextBuffer_;
-      nextBuffer_ = pb;
-
-      // see if we're done with this priority level
-      if(currentEnd_ == 0)
+      if(threads_ > 1)
       {
-        threshold_ += priorityIncrement_;    // increment priority threshold
-        currentEnd_ = overEnd_;    // set current to overflow block
-        overEnd_ = 0;
-        pb = currentBuffer_;        // swap buffers
-        currentBuffer_ = overBuffer_;
-        overBuffer_ = pb;
+        updateBlock(costs, potential);
+      }
+      else
+      {
+        // reset pending_ flags on current priority buffer
+        for(std::vector< int >::iterator pb = current_.begin();
+            pb != current_.end(); ++pb)
+          pending_[*pb] = 0;
+
+        for(std::vector< int >::iterator pb = current_.begin();
+            pb != current_.end(); ++pb)
+          updateCell(costs, potential, *pb);
       }
+      current_.clear();
+
+      // cells pushed below the threshold go next
+      current_.swap(next_);
 
       // check if we've hit the Start cell
-      if(potential[startCell] < POT_HIGH)
-        break;
+      if(batch_)
+      {
+        if(settleTargets(potential))
+          return markTouched(SEARCH_FOUND);
+      }
+      else if(!expand_all_ && potential[start_cell_] < POT_HIGH)
+        return markTouched(SEARCH_FOUND); // finished up here
     }
 
-    printf("After for loop...\n");
-
     //ROS_INFO("CYCLES %d/%d ", cycle, cycles);
-    if(cycle < cycles)
-      return true; // finished up here
+    return markTouched(SEARCH_FAILED);
+  }
+
+  Expander::SearchState DijkstraExpansion::markTouched(SearchState state)
+  {
+    workspace_->markPotential(search_potential_, touched_begin_, touched_end_);
+    touched_begin_ = ns_;
+    touched_end_ = 0;
+    return state;
+  }
+
+  bool DijkstraExpansion::calculatePotentials(unsigned char* costs,
+                                              double start_x, double start_y,
+                                              const std::vector< int >& targets,
+                                              int cycles, float* potential)
+  {
+    targets_.clear();
+    for(unsigned int i = 0; i < targets.size(); i++)
+    {
+      int n = targets[i];
+      if(n < 0 || n >= ns_)
+        continue;
+      if(getCost(costs, n) < lethal_cost_)
+      {
+        targets_.push_back(n);
+        continue;
+      }
+
+      int neighbors[] = {n - 1, n + 1, n - nx_, n + nx_};
+      for(int k = 0; k < 4; k++)
+      {
+        if(neighbors[k] >= 0 && neighbors[k] < ns_ && getCost(costs, neighbors[k]) < lethal_cost_)
+          targets_.push_back(neighbors[k]);
+      }
+    }
+
+    batch_ = true;
+    bool found = calculatePotentials(costs, start_x, start_y, start_x, start_y,
+                                     cycles, potential);
+    batch_ = false;
+    return found;
+  }
+
+  void DijkstraExpansion::updateBlock(unsigned char* costs, float* potential)
+  {
+    int count = current_.size();
+    cells_visited_ += count;
+    updates_.resize(count);
+    colors_.resize(count);
+
+    // small blocks are not worth waking the workers for, they take the same
+    // steps on this thread alone
+    if(count < parallel_block_cells_ * threads_)
+    {
+      found_[0].clear();
+      for(int step = 0; step < BLOCK_STEPS; step++)
+        updateShare(step, costs, potential, 0, count, found_[0]);
+    }
     else
-      return false;
+    {
+      block_costs_ = costs;
+      block_potential_ = potential;
+      barrier_->wait();
+      runWorker(0);
+    }
+
+    // queue in the order of current_, whatever thread found the cells
+    for(int i = 0; i < threads_; i++)
+    {
+      std::vector< int >& found = found_[i];
+      for(unsigned int k = 0; k < found.size(); k += 2)
+      {
+        if(pending_[found[k]] != pending_generation_)
+          enqueue(found[k + 1] < 0 ? next_ : levels_[found[k + 1]], found[k]);
+      }
+      found.clear();
+    }
+  }
+
+  void DijkstraExpansion::runWorker(int worker)
+  {
+    while(true)
+    {
+      // the calling thread joins after starting the block
+      if(worker > 0)
+      {
+        barrier_->wait();
+        if(stop_workers_)
+          return;
+      }
+
+      long count = current_.size();
+      int begin = count * worker / threads_;
+      int end = count * (worker + 1) / threads_;
+      found_[worker].clear();
+      for(int step = 0; step < BLOCK_STEPS; step++)
+      {
+        updateShare(step, block_costs_, block_potential_, begin, end,
+                    found_[worker]);
+        barrier_->wait();
+      }
+
+      if(worker == 0)
+        return;
+    }
+  }
+
+#define INVSQRT2 0.707106781
+
+  void DijkstraExpansion::updateShare(int step, unsigned char* costs,
+                                      float* potential, int begin, int end,
+                                      std::vector< int >& found)
+  {
+    if(step < BLOCK_STEPS - 1)
+    {
+      // cells of one color of a checkerboard read only cells of the other,
+      // so a color is updated at once, each one from the last, and the
+      // first color once more to follow a wave across two cells
+      for(int i = begin; i < end; i++)
+      {
+        int n = current_[i];
+        if(step == 0)
+        {
+          pending_[n] = 0;
+          colors_[i] = (n % nx_ + n / nx_) % 2;
+          updates_[i] = POT_HIGH;
+        }
+        if(colors_[i] != step % 2)
+          continue;
+
+        float c = getCost(costs, n);
+        if(c >= lethal_cost_)
+          continue;
+        float pot = p_calc_->calculatePotential(potential, c, n);
+        if(pot < potential[n])
+          potential[n] = updates_[i] = pot;
+      }
+    }
+    else
+    {
+      // neighbors the dropped cells can lower, as in updateCell() and
+      // push(), only whether they are queued already is left to the caller
+      for(int i = begin; i < end; i++)
+      {
+        float pot = updates_[i];
+        if(pot >= POT_HIGH)
+          continue;
+
+        int n = current_[i];
+        int level = levelFor(pot);
+        int neighbors[] = {n - 1, n + 1, n - nx_, n + nx_};
+        for(int k = 0; k < 4; k++)
+        {
+          int m = neighbors[k];
+          if(m < 0 || m >= ns_)
+            continue;
+          float c = getCost(costs, m);
+          if(c < lethal_cost_ && potential[m] > pot + INVSQRT2 * c)
+          {
+            found.push_back(m);
+            found.push_back(level);
+          }
+        }
+      }
+    }
+  }
+
+  bool DijkstraExpansion::settleTargets(float* potential)
+  {
+    // the cells still to be updated lie above the current level, and an
+    // update never falls below the potential of the cell it comes from
+    float settled = threshold_ - priorityIncrement_;
+    unsigned int i = 0;
+    while(i < targets_.size())
+    {
+      if(potential[targets_[i]] < settled)
+      {
+        targets_[i] = targets_.back();
+        targets_.pop_back();
+      }
+      else
+      {
+        i++;
+      }
+    }
+    return targets_.empty();
   }
 
 //
@@ -174,8 +418,6 @@ namespace NS_Planner
 // No checking of bounds here, this function should be fast
 //
 
-#define INVSQRT2 0.707106781
-
   inline void DijkstraExpansion::updateCell(unsigned char* costs,
                                             float* potential, int n)
   {
@@ -197,28 +439,15 @@ namespace NS_Planner
       float de = INVSQRT2 * (float)getCost(costs, n + nx_);
       potential[n] = pot;
       //ROS_INFO("UPDATE %d %d %d %f", n, n%nx, n/nx, potential[n]);
-      if(pot < threshold_)    // low-cost buffer block
-      {
-        if(potential[n - 1] > pot + le)
-          push_next(n - 1);
-        if(potential[n + 1] > pot + re)
-          push_next(n + 1);
-        if(potential[n - nx_] > pot + ue)
-          push_next(n - nx_);
-        if(potential[n + nx_] > pot + de)
-          push_next(n + nx_);
-      }
-      else            // overflow block
-      {
-        if(potential[n - 1] > pot + le)
-          push_over(n - 1);
-        if(potential[n + 1] > pot + re)
-          push_over(n + 1);
-        if(potential[n - nx_] > pot + ue)
-          push_over(n - nx_);
-        if(potential[n + nx_] > pot + de)
-          push_over(n + nx_);
-      }
+      std::vector< int >& bucket = bucketFor(pot);
+      if(potential[n - 1] > pot + le)
+        push(bucket, costs, n - 1);
+      if(potential[n + 1] > pot + re)
+        push(bucket, costs, n + 1);
+      if(potential[n - nx_] > pot + ue)
+        push(bucket, costs, n - nx_);
+      if(potential[n + nx_] > pot + de)
+        push(bucket, costs, n + nx_);
     }
   }
 
@@ -1,24 +1,28 @@
 #ifndef _DIJKSTRA_H_
 #define _DIJKSTRA_H_
 
-#define PRIORITYBUFSIZE 10000
 #include <math.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <vector>
+#include <algorithm>
 
-#include "Expander.h"
+#include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
 
-// inserting onto the priority blocks
-#define push_cur(n)  { if (n>=0 && n<ns_ && !pending_[n] && getCost(costs, n)<lethal_cost_ && currentEnd_<PRIORITYBUFSIZE){ currentBuffer_[currentEnd_++]=n; pending_[n]=true; }}
-#define push_next(n) { if (n>=0 && n<ns_ && !pending_[n] && getCost(costs, n)<lethal_cost_ &&    nextEnd_<PRIORITYBUFSIZE){    nextBuffer_[   nextEnd_++]=n; pending_[n]=true; }}
-#define push_over(n) { if (n>=0 && n<ns_ && !pending_[n] && getCost(costs, n)<lethal_cost_ &&    overEnd_<PRIORITYBUFSIZE){    overBuffer_[   overEnd_++]=n; pending_[n]=true; }}
+#include "Expander.h"
 
 namespace NS_Planner
 {
   class DijkstraExpansion: public Expander
   {
   public:
+    enum
+    {
+      DEFAULT_PARALLEL_BLOCK_CELLS = 400 ///< Default of setParallelBlockCells(), twice the break-even ParallelDijkstraBenchmark measured
+    };
+
     DijkstraExpansion(PotentialCalculator* p_calc, int nx, int ny);
     ~DijkstraExpansion();
     bool
@@ -26,13 +30,23 @@ namespace NS_Planner
                         double end_x, double end_y, int cycles,
                         float* potential);
 
+    SearchState
+    startSearch(unsigned char* costs, double start_x, double start_y,
+                double end_x, double end_y, int cycles, float* potential);
+
+    SearchState
+    resumeSearch();
+
     /**
-     * @brief  Sets or resets the size of the map
-     * @param nx The x size of the map
-     * @param ny The y size of the map
+     * @brief Propagate from start until every target cell is settled, or no cell is left
+     *
+     * A target that can not be entered is settled with its passable
+     * neighbors instead.
      */
-    void
-    setSize(int nx, int ny); /**< sets or resets the size of the map */
+    bool
+    calculatePotentials(unsigned char* costs, double start_x, double start_y,
+                        const std::vector< int >& targets, int cycles,
+                        float* potential);
 
     void setNeutralCost(unsigned char neutral_cost)
     {
@@ -44,7 +58,99 @@ namespace NS_Planner
     {
       precise_ = precise;
     }
+
+    /**
+     * @brief Propagate to every reachable cell instead of stopping once the end cell is reached
+     */
+    void setExpandAll(bool expand_all)
+    {
+      expand_all_ = expand_all;
+    }
+
+    /**
+     * @brief Split each priority block over threads, the calling one included
+     *
+     * With more than one thread, a block is updated in checkerboard sweeps,
+     * one color, the other, then the first once more, and a cell of one
+     * color only reads cells of the other. Which thread updates a cell does
+     * not change its potential, and small blocks take the same sweeps on the
+     * calling thread, so the result is the same for any thread count above
+     * one. It differs from the serial update of a single thread, where a
+     * cell sees every cell updated before it in the block, within the
+     * interpolation error of the calculator. The sweeps do about 1.4 times
+     * the work of the serial update, so threads only pay with cores to run
+     * them on.
+     */
+    void
+    setThreads(int threads);
+
+    /**
+     * @brief Update blocks of fewer than cells cells per thread on the calling thread alone
+     */
+    void setParallelBlockCells(int cells)
+    {
+      parallel_block_cells_ = std::max(cells, 1);
+    }
+
+    ExpansionStats
+    getStats();
   private:
+    enum
+    {
+      BLOCK_STEPS = 4 ///< Steps of updateBlock(), sweeps over the colors, then the neighbors to queue
+    };
+
+    /**
+     * @brief Queue cell n into bucket if it is on the map, passable and not queued yet
+     */
+    inline void push(std::vector< int >& bucket, unsigned char* costs, int n)
+    {
+      if(n >= 0 && n < ns_ && pending_[n] != pending_generation_ && getCost(costs, n) < lethal_cost_)
+        enqueue(bucket, n);
+    }
+
+    /**
+     * @brief Queue cell n into bucket, it must be on the map, passable and not queued yet
+     */
+    inline void enqueue(std::vector< int >& bucket, int n)
+    {
+      if(bucket.size() == bucket.capacity())
+        queue_growths_++;
+      bucket.push_back(n);
+      pending_[n] = pending_generation_;
+      queued_++;
+
+      // only queued cells get a potential
+      if(n < touched_begin_)
+        touched_begin_ = n;
+      if(n >= touched_end_)
+        touched_end_ = n + 1;
+    }
+
+    /**
+     * @brief Bucket a cell reached from a cell of potential pot goes to
+     */
+    inline std::vector< int >& bucketFor(float pot)
+    {
+      int level = levelFor(pot);
+      return level < 0 ? next_ : levels_[level];
+    }
+
+    /**
+     * @brief Index in levels_ of the bucket for pot, -1 for next_
+     */
+    inline int levelFor(float pot)
+    {
+      if(pot < threshold_)
+        return -1;
+
+      // the level above the current threshold pot falls into, a single
+      // step never skips more levels than the ring holds
+      int ahead = 1 + (int)((pot - threshold_) / priorityIncrement_);
+      if(ahead >= (int)levels_.size())
+        ahead = levels_.size() - 1;
+      return (current_level_ + ahead) % levels_.size();
+    }
 
     /**
      * @brief  Updates the cell at index n
@@ -55,25 +161,77 @@ namespace NS_Planner
     void
     updateCell(unsigned char* costs, float* potential, int n); /** updates the cell at index n */
 
-    float getCost(unsigned char* costs, int n)
-    {
-      float c = costs[n];
-      if(c < lethal_cost_ - 1 || (unknown_ && c == 255))
-      { // lethal_cost 253
-        c = c * factor_ + neutral_cost_; // factor = 3.0  neutral_cost = 50
-        if(c >= lethal_cost_)
-          c = lethal_cost_ - 1;
-        return c;
-      }
-      return lethal_cost_;
-    }
+    /**
+     * @brief Update the cells of current_ from the potentials they started with, on all threads
+     */
+    void
+    updateBlock(unsigned char* costs, float* potential);
+
+    /**
+     * @brief Run one step of updateBlock() on the cells of current_ in [begin, end)
+     * @param found Cells to queue and their levelFor(), filled by the last step
+     */
+    void
+    updateShare(int step, unsigned char* costs, float* potential, int begin,
+                int end, std::vector< int >& found);
+
+    /**
+     * @brief Main loop of the worker threads, worker 0 is the calling thread
+     */
+    void
+    runWorker(int worker);
+
+    void
+    stopWorkers();
+
+    /**
+     * @brief Mark the cells the search touched since the last call in the workspace, so the next reset clears them
+     * @return state
+     */
+    SearchState
+    markTouched(SearchState state);
 
-    /** block priority buffers */
-    int *buffer1_, *buffer2_, *buffer3_; /**< storage buffers for priority blocks */
-    int *currentBuffer_, *nextBuffer_, *overBuffer_; /**< priority buffer block ptrs */
-    int currentEnd_, nextEnd_, overEnd_; /**< end points of arrays */
-    bool *pending_; /**< pending_ cells during propagation */
+    /**
+     * @brief Drop the targets no cell below the current threshold can lower any more
+     * @return True once no target is left
+     */
+    bool
+    settleTargets(float* potential);
+
+    /** block priority buckets, they grow instead of dropping cells and keep their room between plans */
+    std::vector< int > current_; /**< cells processed in this cycle */
+    std::vector< int > next_; /**< cells below the current threshold, processed next cycle */
+    std::vector< std::vector< int > > levels_; /**< ring of buckets for the levels above the current threshold */
+    int current_level_; /**< index of the current level in the ring */
+
+    unsigned long queued_; /**< cells pushed by the running search */
+    unsigned long max_queue_;
+    unsigned long queue_growths_;
+    unsigned int *pending_; /**< pending_ cells during propagation, stamped with pending_generation_ */
+    unsigned int pending_generation_;
     bool precise_;
+    bool expand_all_;
+    bool batch_; /**< stop on targets_ instead of the end cell */
+    int touched_begin_, touched_end_; /**< cells whose potential may have been written since the last markTouched() */
+    std::vector< int > targets_; /**< target cells of a batch search not settled yet */
+
+    /** parallel block updates */
+    int threads_;
+    int parallel_block_cells_; /**< cells per thread below which a block is updated on the calling thread */
+    boost::thread_group workers_;
+    boost::barrier* barrier_; /**< meets all threads between the steps of a block */
+    volatile bool stop_workers_;
+    unsigned char* block_costs_; /**< costs and potential of the running search, for the workers */
+    float* block_potential_;
+    std::vector< float > updates_; /**< new potential of each cell of current_, POT_HIGH if it did not drop */
+    std::vector< unsigned char > colors_; /**< checkerboard color of each cell of current_ */
+    std::vector< std::vector< int > > found_; /**< per thread, passable cells to queue and their levels */
+
+    /** search kept between slices */
+    unsigned char* search_costs_;
+    float* search_potential_;
+    int start_cell_; /**< cell the search stops at, unless expand_all_ or batch_ */
+    int cycle_, cycles_;
 
     /** block priority thresholds */
     float threshold_; /**< current threshold */
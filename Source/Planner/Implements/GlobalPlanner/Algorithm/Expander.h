@@ -4,18 +4,47 @@
 #define POT_HIGH 1.0e10        // unassigned cell potential
 
 #include "PotentialCalculator.h"
+#include "PlannerWorkspace.h"
 
 #include <Console/Console.h>
+#include <Time/Time.h>
 
 namespace NS_Planner
 {
 
+  /**
+   * @class ExpansionStats
+   * @brief Counters of the last calculatePotentials() call
+   */
+  class ExpansionStats
+  {
+  public:
+    ExpansionStats()
+        : cells_visited(0), max_queue(0), queue_growths(0)
+    {
+    }
+
+    unsigned long cells_visited; ///< Cell updates done
+    unsigned long max_queue; ///< Most cells waiting in the queue at once
+    unsigned long queue_growths; ///< Times a queue ran out of room and had to grow
+  };
+
   class Expander
   {
   public:
+    /**
+     * @brief Outcome of a search, or of one slice of it
+     */
+    enum SearchState
+    {
+      SEARCH_FOUND, SEARCH_FAILED, SEARCH_IN_PROGRESS
+    };
+
     Expander(PotentialCalculator* p_calc, int nx, int ny)
-        : unknown_(true), lethal_cost_(253), neutral_cost_(50), factor_(3.0),
-          p_calc_(p_calc)
+        : unknown_(true), lethal_cost_(253), neutral_cost_(50),
+          cells_visited_(0), factor_(3.0),
+          p_calc_(p_calc), workspace_(NULL), slice_cells_(0),
+          slice_seconds_(0), slice_cells_end_(0), slice_time_check_(0)
     {
       setSize(nx, ny);
     }
@@ -25,6 +54,40 @@ namespace NS_Planner
                         double end_x, double end_y, int cycles,
                         float* potential) = 0;
 
+    /**
+     * @brief Start a search like calculatePotentials(), but only run its first slice
+     *
+     * An expander that can not stop mid-way runs the whole search here.
+     * Costs and potential must stay untouched until the search is done.
+     */
+    virtual SearchState startSearch(unsigned char* costs, double start_x,
+                                    double start_y, double end_x,
+                                    double end_y, int cycles,
+                                    float* potential)
+    {
+      if(calculatePotentials(costs, start_x, start_y, end_x, end_y, cycles,
+                             potential))
+        return SEARCH_FOUND;
+      return SEARCH_FAILED;
+    }
+
+    /**
+     * @brief Run the next slice of the search begun by startSearch()
+     */
+    virtual SearchState resumeSearch()
+    {
+      return SEARCH_FAILED;
+    }
+
+    /**
+     * @brief Bound each slice of a search to about cells cell updates and seconds, 0 for no bound
+     */
+    void setSlice(unsigned long cells, double seconds)
+    {
+      slice_cells_ = cells;
+      slice_seconds_ = seconds;
+    }
+
     /**
      * @brief  Sets or resets the size of the map
      * @param nx The x size of the map
@@ -52,17 +115,48 @@ namespace NS_Planner
     {
       unknown_ = unknown;
     }
+    virtual ExpansionStats getStats()
+    {
+      ExpansionStats stats;
+      stats.cells_visited = cells_visited_;
+      return stats;
+    }
+    /**
+     * @brief True if the expander keeps its search between calls
+     *
+     * Such an expander searches from the goal, calculatePotentials() is
+     * called with the goal as start, and it must be told about every cell
+     * that changed through markChanged() or resetSearch().
+     */
+    virtual bool isIncremental()
+    {
+      return false;
+    }
+    /**
+     * @brief The cells in [x0, xn) x [y0, yn) may have changed since the last call
+     */
+    virtual void markChanged(unsigned char* costs, int x0, int y0, int xn,
+                             int yn)
+    {
+    }
+    /**
+     * @brief Drop the kept search, the next call starts from scratch
+     */
+    virtual void resetSearch()
+    {
+    }
+    /**
+     * @brief Set the workspace the per-cell search state is borrowed from, it must fit the map size
+     */
+    void setWorkspace(PlannerWorkspace* workspace)
+    {
+      workspace_ = workspace;
+    }
 
     void clearEndpoint(unsigned char* costs, float* potential, int gx, int gy,
                        int s)
     {
-      printf("clear Endpoint running...\n");
       int startCell = toIndex(gx, gy);
-
-      cout << "startCell = " << startCell << "; ";
-      cout << "gx = " << gx << "; ";
-      cout << "gy = " << gy << "; ";
-      cout << "s = " << s << "\n";
       for(int i = -s; i <= s; i++)
       {
         for(int j = -s; j <= s; j++)
@@ -71,7 +165,6 @@ namespace NS_Planner
            * TODO: n 有可能是负数，这样计算出来不经过检查作为数组下标可能导致崩溃
            */
           int n = startCell + i + nx_ * j;
-          cout << "n = " << n << "\n";
           if(potential[n] < POT_HIGH)
             continue;
           float c = costs[n] + neutral_cost_;
@@ -79,15 +172,62 @@ namespace NS_Planner
           potential[n] = pot;
         }
       }
-      printf("Finish clearEndpoint...\n");
+      workspace_->markPotential(potential, startCell - s - nx_ * s,
+                                startCell + s + nx_ * s + 1);
     }
 
   protected:
+    enum
+    {
+      SLICE_TIME_CELLS = 256 ///< Cells visited between two looks at the clock while a slice runs
+    };
+
     inline int toIndex(int x, int y)
     {
       return x + nx_ * y;
     }
 
+    /**
+     * @brief Start counting the cells and time of a slice
+     */
+    void startSlice()
+    {
+      slice_cells_end_ = cells_visited_ + slice_cells_;
+      slice_time_check_ = cells_visited_ + SLICE_TIME_CELLS;
+      if(slice_seconds_ > 0)
+        slice_end_ = NS_NaviCommon::Time::now() + NS_NaviCommon::Duration(slice_seconds_);
+    }
+
+    /**
+     * @brief True once the slice begun by startSlice() used up its cells or time
+     */
+    bool sliceOver()
+    {
+      if(slice_cells_ > 0 && (unsigned long)cells_visited_ >= slice_cells_end_)
+        return true;
+      // the clock is read every SLICE_TIME_CELLS cells only
+      if(slice_seconds_ <= 0 || (unsigned long)cells_visited_ < slice_time_check_)
+        return false;
+      slice_time_check_ = cells_visited_ + SLICE_TIME_CELLS;
+      return NS_NaviCommon::Time::now() > slice_end_;
+    }
+
+    /**
+     * @brief Traversal cost of cell n, lethal_cost_ if it can not be entered
+     */
+    float getCost(unsigned char* costs, int n)
+    {
+      float c = costs[n];
+      if(c < lethal_cost_ - 1 || (unknown_ && c == 255))
+      { // lethal_cost 253
+        c = c * factor_ + neutral_cost_; // factor = 3.0  neutral_cost = 50
+        if(c >= lethal_cost_)
+          c = lethal_cost_ - 1;
+        return c;
+      }
+      return lethal_cost_;
+    }
+
     /*  */
     int nx_, ny_, ns_; /**< size of grid, in pixels */
     bool unknown_;
@@ -95,6 +235,13 @@ namespace NS_Planner
     int cells_visited_;
     float factor_;
     PotentialCalculator* p_calc_;
+    PlannerWorkspace* workspace_;
+
+    unsigned long slice_cells_;
+    double slice_seconds_;
+    unsigned long slice_cells_end_; ///< cells_visited_ at which the running slice ends
+    unsigned long slice_time_check_; ///< cells_visited_ at which the clock is read next
+    NS_NaviCommon::Time slice_end_;
 
   };
 
@@ -0,0 +1,110 @@
+#include "FieldCache.h"
+#include "Expander.h"
+#include <algorithm>
+
+namespace NS_Planner
+{
+
+  FieldCache::FieldCache(unsigned long max_bytes)
+      : max_bytes_(max_bytes), nx_(0), ny_(0)
+  {
+  }
+
+  void FieldCache::clear(int nx, int ny)
+  {
+    fields_.clear();
+    nx_ = nx;
+    ny_ = ny;
+  }
+
+  float* FieldCache::find(int goal)
+  {
+    for(std::list< Field >::iterator it = fields_.begin(); it != fields_.end();
+        ++it)
+    {
+      if(it->goal != goal)
+        continue;
+      fields_.splice(fields_.begin(), fields_, it);
+      return &fields_.front().potential[0];
+    }
+    return NULL;
+  }
+
+  float* FieldCache::insert(int goal, const unsigned char* costs)
+  {
+    unsigned long ns = (unsigned long)nx_ * ny_;
+    unsigned long field_bytes = ns * (sizeof(float) + sizeof(unsigned char));
+    if(ns == 0 || field_bytes > max_bytes_)
+      return NULL;
+
+    // reuse the arrays of the evicted field if there is one
+    std::list< Field > evicted;
+    while(!fields_.empty() && (fields_.size() + 1) * field_bytes > max_bytes_)
+      evicted.splice(evicted.begin(), fields_, --fields_.end());
+    if(evicted.empty())
+      evicted.push_back(Field());
+
+    fields_.splice(fields_.begin(), evicted, evicted.begin());
+    Field& field = fields_.front();
+    field.goal = goal;
+    field.x0 = field.y0 = 0;
+    field.xn = nx_;
+    field.yn = ny_;
+    field.potential.resize(ns);
+    field.costs.assign(costs, costs + ns);
+    return &field.potential[0];
+  }
+
+  void FieldCache::setReached(int goal)
+  {
+    if(fields_.empty() || fields_.front().goal != goal)
+      return;
+
+    Field& field = fields_.front();
+    int x0 = nx_, y0 = ny_, xn = 0, yn = 0;
+    for(int y = 0; y < ny_; y++)
+    {
+      const float* row = &field.potential[y * nx_];
+      for(int x = 0; x < nx_; x++)
+      {
+        if(row[x] >= POT_HIGH)
+          continue;
+        x0 = std::min(x0, x);
+        xn = std::max(xn, x + 1);
+        y0 = std::min(y0, y);
+        yn = y + 1;
+      }
+    }
+
+    // a cell next to the reached ones can open a way into them
+    field.x0 = std::max(x0 - 1, 0);
+    field.y0 = std::max(y0 - 1, 0);
+    field.xn = std::min(xn + 1, nx_);
+    field.yn = std::min(yn + 1, ny_);
+  }
+
+  void FieldCache::markChanged(const unsigned char* costs, int x0, int y0,
+                               int xn, int yn)
+  {
+    std::list< Field >::iterator it = fields_.begin();
+    while(it != fields_.end())
+    {
+      int cx0 = std::max(x0, it->x0), cy0 = std::max(y0, it->y0);
+      int cxn = std::min(xn, it->xn), cyn = std::min(yn, it->yn);
+
+      bool differs = false;
+      for(int y = cy0; y < cyn && !differs; y++)
+      {
+        int n = y * nx_ + cx0;
+        differs = !std::equal(costs + n, costs + n + cxn - cx0,
+                              &it->costs[n]);
+      }
+
+      if(differs)
+        it = fields_.erase(it);
+      else
+        ++it;
+    }
+  }
+
+} //end namespace global_planner
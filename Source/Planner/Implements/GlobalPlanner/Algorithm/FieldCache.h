@@ -0,0 +1,87 @@
+#ifndef _FIELD_CACHE_H_
+#define _FIELD_CACHE_H_
+
+#include <list>
+#include <vector>
+
+namespace NS_Planner
+{
+
+  /**
+   * @class FieldCache
+   * @brief Potential fields rooted at goal cells, kept for plans to the same goals
+   *
+   * A field covers every cell reachable from its goal, so a plan from any
+   * start only has to trace it back. Each field keeps a copy of the costs it
+   * was calculated on. Cells reported as changed are compared against that
+   * copy, and a field is dropped once a cost it depends on really differs.
+   * The least recently used fields are dropped to stay under the memory cap.
+   */
+  class FieldCache
+  {
+  public:
+    FieldCache(unsigned long max_bytes);
+
+    /**
+     * @brief Drop every field, and fit fields to a nx x ny map
+     */
+    void
+    clear(int nx, int ny);
+
+    int getSizeX() const
+    {
+      return nx_;
+    }
+
+    int getSizeY() const
+    {
+      return ny_;
+    }
+
+    /**
+     * @brief The field rooted at goal, NULL if there is none
+     */
+    float*
+    find(int goal);
+
+    /**
+     * @brief Add a field rooted at goal, calculated on costs, evicting the least recently used ones to fit
+     * @return The potential array to fill in, NULL if a field does not fit at all
+     */
+    float*
+    insert(int goal, const unsigned char* costs);
+
+    /**
+     * @brief Note the cells the field of goal reached, after filling it in
+     */
+    void
+    setReached(int goal);
+
+    /**
+     * @brief Drop the fields whose costs differ from costs in [x0, xn) x [y0, yn)
+     */
+    void
+    markChanged(const unsigned char* costs, int x0, int y0, int xn, int yn);
+
+    unsigned int size() const
+    {
+      return fields_.size();
+    }
+
+  private:
+    class Field
+    {
+    public:
+      int goal;
+      int x0, y0, xn, yn; ///< Bounds of the reached cells and their neighbors, [x0, xn) x [y0, yn)
+      std::vector< float > potential;
+      std::vector< unsigned char > costs; ///< Costs the potential was calculated on
+    };
+
+    std::list< Field > fields_; ///< Most recently used first
+    unsigned long max_bytes_;
+    int nx_, ny_;
+  };
+
+} //end namespace global_planner
+#endif
@@ -2,8 +2,6 @@
 #include <algorithm>
 #include <stdio.h>
 
-#include <string.h>
-
 #define POT_HIGH 1.0e10        // unassigned cell potential
 
 namespace NS_Planner
@@ -13,26 +11,12 @@ namespace NS_Planner
       : Traceback(p_calc), pathStep_(0.5)
   {
     gradx_ = grady_ = NULL;
+    grad_marks_ = NULL;
+    grad_generation_ = 0;
   }
 
   GradientPath::~GradientPath()
   {
-
-    if(gradx_)
-      delete[] gradx_;
-    if(grady_)
-      delete[] grady_;
-  }
-
-  void GradientPath::setSize(int xs, int ys)
-  {
-    Traceback::setSize(xs, ys);
-    if(gradx_)
-      delete[] gradx_;
-    if(grady_)
-      delete[] grady_;
-    gradx_ = new float[xs * ys];
-    grady_ = new float[xs * ys];
   }
 
   bool GradientPath::getPath(float* potential, double start_x, double start_y,
@@ -46,8 +30,12 @@ namespace NS_Planner
     float dx = goal_x - (int)goal_x;
     float dy = goal_y - (int)goal_y;
     int ns = xs_ * ys_;
-    memset(gradx_, 0, ns * sizeof(float));
-    memset(grady_, 0, ns * sizeof(float));
+    // gradients are worked out for the cells along the path only, a new
+    // generation drops the ones of the last path
+    gradx_ = workspace_->getGradX();
+    grady_ = workspace_->getGradY();
+    grad_marks_ = workspace_->getMarks();
+    grad_generation_ = workspace_->nextGeneration();
 
     int c = 0;
     while(c++ < ns * 4)
@@ -258,9 +246,12 @@ namespace NS_Planner
 // positive value are to the right and down
   float GradientPath::gradCell(float* potential, int n)
   {
-    if(gradx_[n] + grady_[n] > 0.0)    // check this cell
+    if(grad_marks_[n] == grad_generation_)    // check this cell
       return 1.0;
 
+    grad_marks_[n] = grad_generation_;
+    gradx_[n] = grady_[n] = 0.0;
+
     if(n < xs_ || n > xs_ * ys_ - xs_)    // would be out of bounds
       return 0.0;
     float cv = potential[n];
@@ -13,9 +13,6 @@ namespace NS_Planner
     GradientPath(PotentialCalculator* p_calc);
     ~GradientPath();
 
-    void
-    setSize(int xs, int ys);
-
     //
     // Path construction
     // Find gradient at array points, interpolate path
@@ -38,7 +35,9 @@ namespace NS_Planner
     float
     gradCell(float* potential, int n);
 
-    float *gradx_, *grady_; /**< gradient arrays, size of potential array */
+    float *gradx_, *grady_; /**< gradient arrays, size of potential array, borrowed from the workspace */
+    unsigned int* grad_marks_; /**< cells whose gradient is set, stamped with grad_generation_ */
+    unsigned int grad_generation_;
 
     float pathStep_; /**< step size for following gradient */
   };
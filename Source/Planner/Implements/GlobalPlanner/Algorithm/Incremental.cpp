@@ -0,0 +1,152 @@
+#include "Incremental.h"
+#include <algorithm>
+
+namespace NS_Planner
+{
+
+  IncrementalExpansion::IncrementalExpansion(PotentialCalculator* p_calc,
+                                             int nx, int ny)
+      : Expander(p_calc, nx, ny), g_(NULL), goal_(-1), positions_(NULL),
+        max_queue_(0), queue_growths_(0)
+  {
+  }
+
+  void IncrementalExpansion::setSize(int nx, int ny)
+  {
+    Expander::setSize(nx, ny);
+    g_ = NULL;
+  }
+
+  void IncrementalExpansion::resetSearch()
+  {
+    g_ = NULL;
+  }
+
+  ExpansionStats IncrementalExpansion::getStats()
+  {
+    ExpansionStats stats;
+    stats.cells_visited = cells_visited_;
+    stats.max_queue = max_queue_;
+    stats.queue_growths = queue_growths_;
+    return stats;
+  }
+
+  void IncrementalExpansion::reset(unsigned char* costs, float* potential,
+                                   int goal)
+  {
+    g_ = potential;
+    goal_ = goal;
+    // the search is kept across calls and may write any cell
+    workspace_->resetPotential(g_);
+    workspace_->markPotential(g_, 0, ns_);
+    rhs_.assign(ns_, POT_HIGH);
+    costs_.assign(costs, costs + ns_);
+
+    positions_ = workspace_->getCellIndex();
+    std::fill(positions_, positions_ + ns_, -1);
+    queue_.reset(positions_);
+
+    rhs_[goal_] = 0;
+    queue_.push(goal_, 0);
+  }
+
+  void IncrementalExpansion::markChanged(unsigned char* costs, int x0, int y0,
+                                         int xn, int yn)
+  {
+    if(g_ == NULL)
+      return;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    xn = std::min(xn, nx_);
+    yn = std::min(yn, ny_);
+
+    for(int y = y0; y < yn; y++)
+    {
+      for(int n = y * nx_ + x0; n < y * nx_ + xn; n++)
+      {
+        if(costs[n] == costs_[n])
+          continue;
+        costs_[n] = costs[n];
+        updateCell(costs, n);
+      }
+    }
+  }
+
+  bool IncrementalExpansion::calculatePotentials(unsigned char* costs,
+                                                 double start_x,
+                                                 double start_y,
+                                                 double end_x, double end_y,
+                                                 int cycles, float* potential)
+  {
+    cells_visited_ = 0;
+    max_queue_ = queue_growths_ = 0;
+
+    int goal = toIndex(start_x, start_y);
+    if(g_ != potential || goal != goal_)
+      reset(costs, potential, goal);
+
+    // stop once the robot is consistent and every cell a step around the
+    // path to it is settled too, the traceback reads those
+    int robot = toIndex(end_x, end_y);
+    float margin = 2.0 * lethal_cost_;
+
+    for(int cycle = 0; !queue_.empty() && cycle < cycles; cycle++)
+    {
+      if(g_[robot] == rhs_[robot] && queue_.topKey() >= g_[robot] + margin)
+        break;
+
+      if(queue_.size() > max_queue_)
+        max_queue_ = queue_.size();
+
+      int n = queue_.pop();
+      cells_visited_++;
+
+      if(g_[n] > rhs_[n])
+      {
+        // the lookahead is lower, settle on it
+        g_[n] = rhs_[n];
+        updateNeighbors(costs, n);
+      }
+      else
+      {
+        // the potential is too low for the current costs, raise it and
+        // let the neighbors that relied on it look for another support
+        g_[n] = POT_HIGH;
+        updateCell(costs, n);
+        updateNeighbors(costs, n);
+      }
+    }
+
+    return g_[robot] < POT_HIGH;
+  }
+
+  void IncrementalExpansion::updateCell(unsigned char* costs, int n)
+  {
+    if(n != goal_)
+    {
+      float rhs = POT_HIGH;
+      float c = getCost(costs, n);
+      if(c < lethal_cost_)
+        rhs = std::min((float)POT_HIGH, p_calc_->calculatePotential(g_, c, n));
+      rhs_[n] = rhs;
+    }
+
+    bool queued = positions_[n] >= 0;
+    if(g_[n] != rhs_[n])
+    {
+      float key = std::min(g_[n], rhs_[n]);
+      if(queued)
+        queue_.update(n, key);
+      else
+      {
+        if(queue_.size() == queue_.capacity())
+          queue_growths_++;
+        queue_.push(n, key);
+      }
+    }
+    else if(queued)
+      queue_.remove(n);
+  }
+
+} //end namespace global_planner
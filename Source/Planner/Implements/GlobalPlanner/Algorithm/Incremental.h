@@ -0,0 +1,88 @@
+#ifndef _INCREMENTAL_H_
+#define _INCREMENTAL_H_
+
+#include <vector>
+
+#include "Expander.h"
+#include "IndexedHeap.h"
+
+namespace NS_Planner
+{
+
+  /**
+   * @class IncrementalExpansion
+   * @brief Lifelong planning expansion from the goal that repairs its field between calls
+   *
+   * The potential of every cell is its cost to the goal, kept in the
+   * potential array from call to call together with a one step lookahead
+   * value (LPA*). As long as the goal cell stays the same, a call only
+   * repairs the cells whose cost changed and the cells their change
+   * reaches, up to the robot. The robot moving costs nothing when it moves
+   * towards the goal. A cell is updated from its neighbors by the
+   * PotentialCalculator, as in Dijkstra.
+   */
+  class IncrementalExpansion: public Expander
+  {
+  public:
+    IncrementalExpansion(PotentialCalculator* p_calc, int nx, int ny);
+
+    /**
+     * @param start_x, start_y The goal the field is kept for
+     * @param end_x, end_y The robot, the search stops once its potential is known
+     */
+    bool
+    calculatePotentials(unsigned char* costs, double start_x, double start_y,
+                        double end_x, double end_y, int cycles,
+                        float* potential);
+
+    void
+    setSize(int nx, int ny);
+
+    bool isIncremental()
+    {
+      return true;
+    }
+
+    void
+    markChanged(unsigned char* costs, int x0, int y0, int xn, int yn);
+
+    void
+    resetSearch();
+
+    ExpansionStats
+    getStats();
+  private:
+    /**
+     * @brief Start a new field for goal
+     */
+    void
+    reset(unsigned char* costs, float* potential, int goal);
+
+    /**
+     * @brief Recalculate the lookahead of n and queue it if it is inconsistent
+     */
+    void
+    updateCell(unsigned char* costs, int n);
+
+    inline void updateNeighbors(unsigned char* costs, int n)
+    {
+      updateCell(costs, n - 1);
+      updateCell(costs, n + 1);
+      updateCell(costs, n - nx_);
+      updateCell(costs, n + nx_);
+    }
+
+    float* g_; /**< the potential array of the kept field, NULL when there is none */
+    std::vector< float > rhs_; /**< one step lookahead of every cell from its neighbors */
+    std::vector< unsigned char > costs_; /**< the costs the field was calculated with */
+    int goal_;
+
+    IndexedHeap queue_; /**< inconsistent cells keyed by the lower of potential and lookahead */
+    int* positions_; /**< heap positions, -1 for cells not queued */
+
+    unsigned long max_queue_;
+    unsigned long queue_growths_;
+  };
+
+} //end namespace global_planner
+#endif
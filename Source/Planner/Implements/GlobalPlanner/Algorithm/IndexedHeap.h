@@ -0,0 +1,195 @@
+#ifndef _INDEXED_HEAP_H_
+#define _INDEXED_HEAP_H_
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+
+namespace NS_Planner
+{
+
+  /**
+   * @class IndexedHeap
+   * @brief 4-ary min heap of cells that supports lowering the key of a queued cell
+   *
+   * The heap position of every queued cell is kept in a per-cell array owned
+   * by the caller. The caller also tracks which cells are queued, the
+   * positions of other cells are never read.
+   */
+  class IndexedHeap
+  {
+  public:
+    IndexedHeap()
+        : positions_(NULL)
+    {
+    }
+
+    /**
+     * @brief Empty the heap and use positions as the per-cell position array
+     */
+    void reset(int* positions)
+    {
+      positions_ = positions;
+      heap_.clear();
+    }
+
+    bool empty() const
+    {
+      return heap_.empty();
+    }
+
+    unsigned int size() const
+    {
+      return heap_.size();
+    }
+
+    /**
+     * @brief Entries the heap holds before it has to grow, it keeps its room across reset()
+     */
+    unsigned int capacity() const
+    {
+      return heap_.capacity();
+    }
+
+    float topKey() const
+    {
+      return heap_[0].key;
+    }
+
+    int topCell() const
+    {
+      return heap_[0].cell;
+    }
+
+    void push(int cell, float key)
+    {
+      heap_.push_back(Entry(cell, key));
+      siftUp(heap_.size() - 1);
+    }
+
+    /**
+     * @brief Lower the key of a queued cell
+     */
+    void decrease(int cell, float key)
+    {
+      int i = positions_[cell];
+      heap_[i].key = key;
+      siftUp(i);
+    }
+
+    /**
+     * @brief Change the key of a queued cell in either direction
+     */
+    void update(int cell, float key)
+    {
+      int i = positions_[cell];
+      if(key < heap_[i].key)
+      {
+        heap_[i].key = key;
+        siftUp(i);
+      }
+      else
+      {
+        heap_[i].key = key;
+        siftDown(i);
+      }
+    }
+
+    /**
+     * @brief Take a queued cell out, wherever it is in the heap
+     */
+    void remove(int cell)
+    {
+      int i = positions_[cell];
+      positions_[cell] = -1;
+
+      Entry last = heap_.back();
+      heap_.pop_back();
+      if(i == (int)heap_.size())
+        return;
+
+      heap_[i] = last;
+      positions_[last.cell] = i;
+      if(i > 0 && last.key < heap_[(i - 1) / ARITY].key)
+        siftUp(i);
+      else
+        siftDown(i);
+    }
+
+    /**
+     * @brief Remove and return the cell with the lowest key, its position becomes -1
+     */
+    int pop()
+    {
+      int cell = heap_[0].cell;
+      remove(cell);
+      return cell;
+    }
+
+  private:
+    enum
+    {
+      ARITY = 4
+    };
+
+    struct Entry
+    {
+      Entry(int cell_, float key_)
+          : cell(cell_), key(key_)
+      {
+      }
+
+      int cell;
+      float key;
+    };
+
+    void siftUp(int i)
+    {
+      Entry entry = heap_[i];
+      while(i > 0)
+      {
+        int parent = (i - 1) / ARITY;
+        if(!(entry.key < heap_[parent].key))
+          break;
+        heap_[i] = heap_[parent];
+        positions_[heap_[i].cell] = i;
+        i = parent;
+      }
+      heap_[i] = entry;
+      positions_[entry.cell] = i;
+    }
+
+    void siftDown(int i)
+    {
+      Entry entry = heap_[i];
+      int size = heap_.size();
+      while(true)
+      {
+        int first = i * ARITY + 1;
+        if(first >= size)
+          break;
+
+        int last = std::min(first + ARITY, size);
+        int best = first;
+        for(int child = first + 1; child < last; child++)
+        {
+          if(heap_[child].key < heap_[best].key)
+            best = child;
+        }
+
+        if(!(heap_[best].key < entry.key))
+          break;
+        heap_[i] = heap_[best];
+        positions_[heap_[i].cell] = i;
+        i = best;
+      }
+      heap_[i] = entry;
+      positions_[entry.cell] = i;
+    }
+
+    std::vector< Entry > heap_;
+    int* positions_;
+  };
+
+} //end namespace global_planner
+#endif
@@ -0,0 +1,387 @@
+#include "JumpPoint.h"
+#include <algorithm>
+#include <string.h>
+
+namespace NS_Planner
+{
+
+  JumpPointExpansion::JumpPointExpansion(PotentialCalculator* p_calc, int nx,
+                                         int ny)
+      : Expander(p_calc, nx, ny), table_lethal_cost_(0), table_unknown_(false),
+        parent_(NULL), closed_(NULL),
+        closed_generation_(0), goal_i_(0), goal_x_(0), goal_y_(0),
+        max_queue_(0), queue_growths_(0)
+  {
+  }
+
+  void JumpPointExpansion::setSize(int nx, int ny)
+  {
+    Expander::setSize(nx, ny);
+    table_costs_.clear();
+  }
+
+  ExpansionStats JumpPointExpansion::getStats()
+  {
+    ExpansionStats stats;
+    stats.cells_visited = cells_visited_;
+    stats.max_queue = max_queue_;
+    stats.queue_growths = queue_growths_;
+    return stats;
+  }
+
+  bool JumpPointExpansion::calculatePotentials(unsigned char* costs,
+                                               double start_x, double start_y,
+                                               double end_x, double end_y,
+                                               int cycles, float* potential)
+  {
+    cells_visited_ = 0;
+    max_queue_ = queue_growths_ = 0;
+
+    // heap positions and parents are only read for cells the search reached
+    queue_.reset(workspace_->getCellIndex());
+    parent_ = workspace_->getCellParent();
+    closed_ = workspace_->getMarks();
+    closed_generation_ = workspace_->nextGeneration();
+
+    updateJumpTables(costs);
+
+    // any cell may be written, the next search clears them all
+    workspace_->resetPotential(potential);
+    workspace_->markPotential(potential, 0, ns_);
+    touched_.clear();
+
+    goal_x_ = (int)end_x;
+    goal_y_ = (int)end_y;
+    goal_i_ = toIndex(end_x, end_y);
+
+    int start_i = toIndex(start_x, start_y);
+    potential[start_i] = 0;
+    parent_[start_i] = -1;
+    touched_.push_back(start_i);
+    queue_.push(start_i, heuristic(start_i));
+
+    for(int cycle = 0; !queue_.empty() && cycle < cycles; cycle++)
+    {
+      if(queue_.size() > max_queue_)
+        max_queue_ = queue_.size();
+
+      int n = queue_.pop();
+      closed_[n] = closed_generation_;
+      cells_visited_++;
+
+      if(n == goal_i_)
+      {
+        writePath(costs, potential, n);
+        return true;
+      }
+
+      expand(costs, potential, n);
+    }
+
+    return false;
+  }
+
+  int JumpPointExpansion::jumpStraight(unsigned char* costs, int n, int dx,
+                                       int dy, int& steps, bool enter_graded)
+  {
+    unsigned short entry = jumpTable(dx, dy)[n];
+    int run = entry >> RUN_TYPE_BITS;
+
+    // the goal ends any run that crosses it
+    int offset = -1;
+    if(dy == 0 && goal_y_ == n / nx_)
+      offset = (goal_x_ - n % nx_) * dx;
+    else if(dx == 0 && goal_x_ == n % nx_)
+      offset = (goal_y_ - n / nx_) * dy;
+    if(offset > 0 && offset < run)
+    {
+      steps += offset;
+      return goal_i_;
+    }
+
+    steps += run;
+    switch(entry & RUN_TYPE_MASK)
+    {
+      case RUN_JUMP_POINT:
+        return n + run * (dx + dy * nx_);
+      case RUN_GRADED:
+        return enter_graded ? n + run * (dx + dy * nx_) : -1;
+      default:
+        return -1;
+    }
+  }
+
+  void JumpPointExpansion::updateJumpTables(unsigned char* costs)
+  {
+    if((int)table_costs_.size() != ns_ || table_lethal_cost_ != lethal_cost_ || table_unknown_ != unknown_)
+    {
+      table_costs_.assign(costs, costs + ns_);
+      table_lethal_cost_ = lethal_cost_;
+      table_unknown_ = unknown_;
+      for(int i = 0; i < 4; i++)
+        jump_tables_[i].assign(ns_, (1 << RUN_TYPE_BITS) | RUN_BLOCKED);
+
+      for(int y = 0; y < ny_; y++)
+        buildRow(costs, y);
+      dirty_columns_.assign(nx_, 1);
+      buildColumns(costs, dirty_columns_);
+      return;
+    }
+
+    // a changed cell moves the runs of the rows and columns next to it
+    dirty_rows_.assign(ny_, 0);
+    dirty_columns_.assign(nx_, 0);
+    bool changed = false;
+    for(int y = 0; y < ny_; y++)
+    {
+      unsigned char* row = costs + y * nx_;
+      unsigned char* old_row = &table_costs_[y * nx_];
+      if(memcmp(row, old_row, nx_) == 0)
+        continue;
+
+      int x0 = 0, x1 = nx_ - 1;
+      while(row[x0] == old_row[x0])
+        x0++;
+      while(row[x1] == old_row[x1])
+        x1--;
+      memcpy(old_row, row, nx_);
+
+      for(int x = std::max(x0 - 1, 0); x <= std::min(x1 + 1, nx_ - 1); x++)
+        dirty_columns_[x] = 1;
+      for(int r = std::max(y - 1, 0); r <= std::min(y + 1, ny_ - 1); r++)
+        dirty_rows_[r] = 1;
+      changed = true;
+    }
+    if(!changed)
+      return;
+
+    for(int y = 0; y < ny_; y++)
+    {
+      if(dirty_rows_[y])
+        buildRow(costs, y);
+    }
+    buildColumns(costs, dirty_columns_);
+  }
+
+  void JumpPointExpansion::buildRow(unsigned char* costs, int y)
+  {
+    // the border rows and columns are never searched
+    if(y == 0 || y == ny_ - 1)
+      return;
+
+    unsigned short* east = &jump_tables_[0][0];
+    unsigned short* west = &jump_tables_[1][0];
+    int first = y * nx_ + 1, last = y * nx_ + nx_ - 2;
+
+    for(int n = last; n >= first; n--)
+      east[n] = jumpEntry(costs, n, 1, nx_, east);
+    for(int n = first; n <= last; n++)
+      west[n] = jumpEntry(costs, n, -1, nx_, west);
+  }
+
+  void JumpPointExpansion::buildColumns(unsigned char* costs,
+                                        const std::vector< char >& columns)
+  {
+    unsigned short* south = &jump_tables_[2][0];
+    unsigned short* north = &jump_tables_[3][0];
+
+    column_list_.clear();
+    for(int x = 1; x < nx_ - 1; x++)
+    {
+      if(columns[x])
+        column_list_.push_back(x);
+    }
+    if(column_list_.empty())
+      return;
+
+    // sweep along the rows so the tables are walked in memory order
+    for(int y = ny_ - 2; y >= 1; y--)
+    {
+      for(unsigned int i = 0; i < column_list_.size(); i++)
+      {
+        int n = y * nx_ + column_list_[i];
+        south[n] = jumpEntry(costs, n, nx_, 1, south);
+      }
+    }
+    for(int y = 1; y <= ny_ - 2; y++)
+    {
+      for(unsigned int i = 0; i < column_list_.size(); i++)
+      {
+        int n = y * nx_ + column_list_[i];
+        north[n] = jumpEntry(costs, n, -nx_, 1, north);
+      }
+    }
+  }
+
+  int JumpPointExpansion::jumpDiagonal(unsigned char* costs, int n, int dx,
+                                       int dy, int& steps)
+  {
+    int step = dx + dy * nx_;
+
+    while(true)
+    {
+      // never cut a corner, the graded cells at a corner are searched from n
+      if(!isFree(costs, n + dx) || !isFree(costs, n + dy * nx_))
+      {
+        if(steps > 0 && isPassable(costs, n + dx) && isPassable(costs, n + dy * nx_))
+          return n;
+        return -1;
+      }
+
+      n += step;
+      steps++;
+
+      if(!isFree(costs, n))
+        return isPassable(costs, n) ? n : -1;
+
+      if(n == goal_i_)
+        return n;
+
+      // graded cells ahead are entered from the jump points at the end of
+      // the run, they do not make every cell of a diagonal a jump point
+      int axis_steps = 0;
+      if(jumpStraight(costs, n, dx, 0, axis_steps, false) >= 0 || jumpStraight(
+          costs, n, 0, dy, axis_steps, false) >= 0)
+        return n;
+    }
+  }
+
+  void JumpPointExpansion::expand(unsigned char* costs, float* potential, int n)
+  {
+    int p = parent_[n];
+
+    // graded cells and the start are searched in every direction, the
+    // directions pruned below only have graded cells searched as single steps
+    for(int dy = -1; dy <= 1; dy++)
+    {
+      for(int dx = -1; dx <= 1; dx++)
+      {
+        if(dx == 0 && dy == 0)
+          continue;
+        if(p < 0 || !isFree(costs, n) || isGraded(costs, n + dx + dy * nx_))
+          expandDirection(costs, potential, n, dx, dy);
+      }
+    }
+    if(p < 0 || !isFree(costs, n))
+      return;
+
+    int x = n % nx_, y = n / nx_, px = p % nx_, py = p / nx_;
+    int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+
+    if(dx != 0 && dy != 0)
+    {
+      expandDirection(costs, potential, n, dx, 0);
+      expandDirection(costs, potential, n, 0, dy);
+      expandDirection(costs, potential, n, dx, dy);
+    }
+    else if(dx != 0)
+    {
+      expandDirection(costs, potential, n, dx, 0);
+      expandDirection(costs, potential, n, 0, 1);
+      expandDirection(costs, potential, n, 0, -1);
+      expandDirection(costs, potential, n, dx, 1);
+      expandDirection(costs, potential, n, dx, -1);
+    }
+    else
+    {
+      expandDirection(costs, potential, n, 0, dy);
+      expandDirection(costs, potential, n, 1, 0);
+      expandDirection(costs, potential, n, -1, 0);
+      expandDirection(costs, potential, n, 1, dy);
+      expandDirection(costs, potential, n, -1, dy);
+    }
+  }
+
+  void JumpPointExpansion::expandDirection(unsigned char* costs,
+                                           float* potential, int n, int dx,
+                                           int dy)
+  {
+    int m = n + dx + dy * nx_;
+    if(!isPassable(costs, m))
+      return;
+
+    int s, steps = 0;
+    if(dx == 0 || dy == 0)
+    {
+      s = jumpStraight(costs, n, dx, dy, steps, true);
+    }
+    else
+    {
+      // no diagonal step past a lethal corner
+      if(!isPassable(costs, n + dx) || !isPassable(costs, n + dy * nx_))
+        return;
+
+      if(isFree(costs, m) && isFree(costs, n + dx) && isFree(costs, n + dy * nx_))
+        s = jumpDiagonal(costs, n, dx, dy, steps);
+      else
+      {
+        s = m;
+        steps = 1;
+      }
+    }
+
+    if(s >= 0)
+      add(costs, potential, n, s, dx, dy, steps);
+  }
+
+  void JumpPointExpansion::add(unsigned char* costs, float* potential, int n,
+                               int s, int dx, int dy, int steps)
+  {
+    if(closed_[s] == closed_generation_)
+      return;
+
+    // every cell before s is free
+    float step_length = (dx != 0 && dy != 0) ? M_SQRT2 : 1.0;
+    float pot = potential[n] + step_length * ((steps - 1) * neutral_cost_ + getCost(
+        costs, s));
+    if(pot >= potential[s])
+      return;
+
+    if(potential[s] < POT_HIGH)
+    {
+      potential[s] = pot;
+      parent_[s] = n;
+      queue_.decrease(s, pot + heuristic(s));
+      return;
+    }
+
+    potential[s] = pot;
+    parent_[s] = n;
+    touched_.push_back(s);
+    if(queue_.size() == queue_.capacity())
+      queue_growths_++;
+    queue_.push(s, pot + heuristic(s));
+  }
+
+  void JumpPointExpansion::writePath(unsigned char* costs, float* potential,
+                                     int goal)
+  {
+    // fill in the cells jumped over, walking each jump from its parent
+    path_cells_.clear();
+    int c = goal;
+    for(int p = parent_[c]; p >= 0; c = p, p = parent_[c])
+    {
+      int dx = (c % nx_ > p % nx_) - (c % nx_ < p % nx_);
+      int dy = (c / nx_ > p / nx_) - (c / nx_ < p / nx_);
+      int step = dx + dy * nx_;
+      float step_length = (dx != 0 && dy != 0) ? M_SQRT2 : 1.0;
+
+      float pot = potential[p];
+      for(int m = p + step;; m += step)
+      {
+        pot += step_length * getCost(costs, m);
+        path_cells_.push_back(std::make_pair(m, pot));
+        if(m == c)
+          break;
+      }
+    }
+    path_cells_.push_back(std::make_pair(c, 0.0f));
+
+    // only the path keeps a potential, so the traceback can not leave it
+    for(unsigned int i = 0; i < touched_.size(); i++)
+      potential[touched_[i]] = POT_HIGH;
+    for(unsigned int i = 0; i < path_cells_.size(); i++)
+      potential[path_cells_[i].first] = path_cells_[i].second;
+  }
+
+} //end namespace global_planner
@@ -0,0 +1,201 @@
+#ifndef _JUMP_POINT_H_
+#define _JUMP_POINT_H_
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Expander.h"
+#include "IndexedHeap.h"
+#include "../../../../CostMap/CostMap2D/CostValues.h"
+
+namespace NS_Planner
+{
+
+  /**
+   * @class JumpPointExpansion
+   * @brief Jump point search on the 8-connected grid
+   *
+   * Runs of FREE_SPACE cells are crossed in straight and diagonal jumps that
+   * only stop where the surrounding cells change, so open floor costs a few
+   * expansions instead of one per cell. Cells with a graded cost are searched
+   * cell by cell like A*. When the goal is reached only the cells along the
+   * found path get a potential, which decreases towards the start, so
+   * GradientPath and GridPath follow it cell by cell.
+   *
+   * Where every straight jump from a cell ends is kept in tables (JPS+).
+   * They are built from a copy of the costmap and only the rows and columns
+   * around cells that differ from that copy are rebuilt before a search.
+   */
+  class JumpPointExpansion: public Expander
+  {
+  public:
+    JumpPointExpansion(PotentialCalculator* p_calc, int nx, int ny);
+
+    bool
+    calculatePotentials(unsigned char* costs, double start_x, double start_y,
+                        double end_x, double end_y, int cycles,
+                        float* potential);
+
+    void
+    setSize(int nx, int ny);
+
+    ExpansionStats
+    getStats();
+  private:
+    /**
+     * How a straight run ends, kept in the low bits of a jump table entry
+     * below the number of steps
+     */
+    enum
+    {
+      RUN_JUMP_POINT = 0, ///< At a free jump point
+      RUN_GRADED = 1, ///< At a graded cell
+      RUN_BLOCKED = 2, ///< Before a lethal cell
+      RUN_TYPE_BITS = 2,
+      RUN_TYPE_MASK = 3,
+      MAX_RUN_STEPS = 16383 ///< Longer runs get an extra jump point
+    };
+
+    /**
+     * @brief Jump table of the axis direction dx, dy
+     */
+    inline std::vector< unsigned short >& jumpTable(int dx, int dy)
+    {
+      return jump_tables_[dx > 0 ? 0 : dx < 0 ? 1 : dy > 0 ? 2 : 3];
+    }
+
+    /**
+     * @brief A free cell m reached by step is a jump point if a side opens up past an obstacle, or graded cells start at a side
+     */
+    inline bool isForced(unsigned char* costs, int m, int step, int side)
+    {
+      return (isFree(costs, m + side) && !isFree(costs, m - step + side)) || (isFree(
+          costs, m - side) && !isFree(costs, m - step - side)) || (isGraded(
+          costs, m + side) && !isGraded(costs, m - step + side)) || (isGraded(
+          costs, m - side) && !isGraded(costs, m - step - side));
+    }
+
+    /**
+     * @brief Jump table entry of n, from the entry of the next cell in the direction of step
+     */
+    inline unsigned short jumpEntry(unsigned char* costs, int n, int step,
+                                    int side, const unsigned short* table)
+    {
+      int m = n + step;
+      if(!isFree(costs, m))
+        return (1 << RUN_TYPE_BITS) | (isPassable(costs, m) ? RUN_GRADED : RUN_BLOCKED);
+      if(isForced(costs, m, step, side))
+        return (1 << RUN_TYPE_BITS) | RUN_JUMP_POINT;
+
+      int steps = (table[m] >> RUN_TYPE_BITS) + 1;
+      if(steps > MAX_RUN_STEPS)
+        return (1 << RUN_TYPE_BITS) | RUN_JUMP_POINT;
+      return (steps << RUN_TYPE_BITS) | (table[m] & RUN_TYPE_MASK);
+    }
+
+    /**
+     * @brief Bring the jump tables up to date with costs
+     */
+    void
+    updateJumpTables(unsigned char* costs);
+
+    /**
+     * @brief Rebuild the east and west tables of row y
+     */
+    void
+    buildRow(unsigned char* costs, int y);
+
+    /**
+     * @brief Rebuild the south and north tables of the columns flagged in columns
+     */
+    void
+    buildColumns(unsigned char* costs, const std::vector< char >& columns);
+
+    inline bool isFree(unsigned char* costs, int n)
+    {
+      return costs[n] == NS_CostMap::FREE_SPACE;
+    }
+
+    inline bool isPassable(unsigned char* costs, int n)
+    {
+      return getCost(costs, n) < lethal_cost_;
+    }
+
+    /**
+     * @brief Passable but not free, such cells are searched one by one
+     */
+    inline bool isGraded(unsigned char* costs, int n)
+    {
+      return !isFree(costs, n) && isPassable(costs, n);
+    }
+
+    /**
+     * @brief Jump from n along a grid axis
+     * @param steps Incremented by the cells crossed
+     * @param enter_graded Whether a graded cell ending the run is returned as the jump point
+     * @return The jump point reached, -1 if the run ends without one
+     */
+    int
+    jumpStraight(unsigned char* costs, int n, int dx, int dy, int& steps,
+                 bool enter_graded);
+
+    /**
+     * @brief Jump from n along a diagonal, stopping where an axis jump finds a jump point or at graded cells
+     */
+    int
+    jumpDiagonal(unsigned char* costs, int n, int dx, int dy, int& steps);
+
+    /**
+     * @brief Queue the successors of n, pruned by the direction n was reached from
+     */
+    void
+    expand(unsigned char* costs, float* potential, int n);
+
+    /**
+     * @brief Queue the successor of n in direction dx, dy, by a jump over free cells or a single step
+     */
+    void
+    expandDirection(unsigned char* costs, float* potential, int n, int dx,
+                    int dy);
+
+    /**
+     * @brief Queue s, steps cells from n in direction dx, dy
+     */
+    void
+    add(unsigned char* costs, float* potential, int n, int s, int dx, int dy,
+        int steps);
+
+    /**
+     * @brief Replace the potentials of the search by the ones along the path to goal
+     */
+    void
+    writePath(unsigned char* costs, float* potential, int goal);
+
+    inline float heuristic(int n)
+    {
+      int dx = abs(n % nx_ - goal_x_), dy = abs(n / nx_ - goal_y_);
+      return neutral_cost_ * (dx > dy ? dx + (M_SQRT2 - 1) * dy : dy + (M_SQRT2 - 1) * dx);
+    }
+
+    std::vector< unsigned short > jump_tables_[4]; /**< steps and end of the straight run from each cell, east, west, south and north */
+    std::vector< unsigned char > table_costs_; /**< costs the jump tables were built from */
+    unsigned char table_lethal_cost_;
+    bool table_unknown_;
+    std::vector< char > dirty_rows_, dirty_columns_;
+    std::vector< int > column_list_;
+
+    IndexedHeap queue_; /**< open cells keyed by potential plus octile distance to the goal */
+    int* parent_; /**< jump point each cell was reached from, -1 for the start */
+    unsigned int* closed_; /**< expanded cells, stamped with closed_generation_ */
+    unsigned int closed_generation_;
+    std::vector< int > touched_; /**< cells given a potential by the search */
+    std::vector< std::pair< int, float > > path_cells_;
+    int goal_i_, goal_x_, goal_y_;
+
+    unsigned long max_queue_;
+    unsigned long queue_growths_;
+  };
+
+} //end namespace global_planner
+#endif
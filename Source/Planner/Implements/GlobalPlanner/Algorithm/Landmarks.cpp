@@ -0,0 +1,355 @@
+#include "Landmarks.h"
+
+#include <stdio.h>
+#include <boost/bind.hpp>
+
+#include <Console/Console.h>
+
+namespace NS_Planner
+{
+
+  namespace
+  {
+    const unsigned int LANDMARK_FILE_MAGIC = 0x4b4d4c53; // "SLMK"
+
+    struct LandmarkFileHeader
+    {
+      unsigned int magic;
+      unsigned int checksum;
+      int nx, ny, count, compact;
+    };
+  }
+
+  LandmarkTable::LandmarkTable(int nx, int ny, int count, bool compact,
+                               unsigned long version)
+      : nx_(nx), ny_(ny), count_(count), compact_(compact), version_(version),
+        cells_(count, -1), scales_(count, 0)
+  {
+    if(compact_)
+      compact_values_.assign(nx * ny * count, (unsigned short)UNREACHED);
+    else
+      values_.assign(nx * ny * count, POT_HIGH);
+  }
+
+  void LandmarkTable::setPotentials(int l, int cell, const float* potential)
+  {
+    int ns = nx_ * ny_;
+    cells_[l] = cell;
+
+    if(!compact_)
+    {
+      for(int n = 0; n < ns; n++)
+        values_[n * count_ + l] = potential[n];
+      return;
+    }
+
+    // spread the reached potentials over the steps below UNREACHED
+    float highest = 0;
+    for(int n = 0; n < ns; n++)
+    {
+      if(potential[n] < POT_HIGH && potential[n] > highest)
+        highest = potential[n];
+    }
+    float scale = highest > 0 ? highest / (UNREACHED - 1) : 1;
+    scales_[l] = scale;
+
+    for(int n = 0; n < ns; n++)
+    {
+      if(potential[n] < POT_HIGH)
+        compact_values_[n * count_ + l] = (unsigned short)(potential[n] / scale + 0.5);
+    }
+  }
+
+  bool LandmarkTable::save(const std::string& file,
+                           unsigned long checksum) const
+  {
+    FILE* fp = fopen(file.c_str(), "wb");
+    if(fp == NULL)
+    {
+      printf("Unable to write landmark tables to %s.\n", file.c_str());
+      return false;
+    }
+
+    LandmarkFileHeader header;
+    header.magic = LANDMARK_FILE_MAGIC;
+    header.checksum = (unsigned int)checksum;
+    header.nx = nx_;
+    header.ny = ny_;
+    header.count = count_;
+    header.compact = compact_ ? 1 : 0;
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fwrite(&cells_[0], sizeof(int), count_, fp) == (size_t)count_;
+    ok = ok && fwrite(&scales_[0], sizeof(float), count_, fp) == (size_t)count_;
+    if(compact_)
+      ok = ok && fwrite(&compact_values_[0], sizeof(unsigned short),
+                        compact_values_.size(), fp) == compact_values_.size();
+    else
+      ok = ok && fwrite(&values_[0], sizeof(float), values_.size(), fp) == values_.size();
+    fclose(fp);
+
+    if(!ok)
+    {
+      printf("Failed to write landmark tables to %s.\n", file.c_str());
+      remove(file.c_str());
+    }
+    return ok;
+  }
+
+  LandmarkTable* LandmarkTable::load(const std::string& file,
+                                     unsigned long checksum, int nx, int ny,
+                                     int count, bool compact,
+                                     unsigned long version)
+  {
+    FILE* fp = fopen(file.c_str(), "rb");
+    if(fp == NULL)
+      return NULL;
+
+    LandmarkFileHeader header;
+    if(fread(&header, sizeof(header), 1, fp) != 1 || header.magic != LANDMARK_FILE_MAGIC || header.checksum != (unsigned int)checksum || header.nx != nx || header.ny != ny || header.count != count || header.compact != (compact ? 1 : 0))
+    {
+      fclose(fp);
+      return NULL;
+    }
+
+    LandmarkTable* table = new LandmarkTable(nx, ny, count, compact, version);
+    bool ok = fread(&table->cells_[0], sizeof(int), count, fp) == (size_t)count;
+    ok = ok && fread(&table->scales_[0], sizeof(float), count, fp) == (size_t)count;
+    if(compact)
+      ok = ok && fread(&table->compact_values_[0], sizeof(unsigned short),
+                       table->compact_values_.size(), fp) == table->compact_values_.size();
+    else
+      ok = ok && fread(&table->values_[0], sizeof(float), table->values_.size(),
+                       fp) == table->values_.size();
+    fclose(fp);
+
+    if(!ok)
+    {
+      delete table;
+      return NULL;
+    }
+    return table;
+  }
+
+  LandmarkHeuristic::LandmarkHeuristic(PotentialCalculator* p_calc, int count,
+                                       bool compact, unsigned long max_bytes,
+                                       const std::string& file)
+      : p_calc_(p_calc), count_(count), compact_(compact),
+        max_bytes_(max_bytes), file_(file), lethal_cost_(253),
+        neutral_cost_(50), factor_(3.0), unknown_(true), latest_version_(0),
+        built_version_(0), building_(false), stop_(false), nx_(0), ny_(0)
+  {
+  }
+
+  LandmarkHeuristic::~LandmarkHeuristic()
+  {
+    stop_ = true;
+    build_thread_.join();
+    delete p_calc_;
+  }
+
+  void LandmarkHeuristic::setCosts(unsigned char lethal_cost,
+                                   unsigned char neutral_cost, float factor,
+                                   bool unknown)
+  {
+    lethal_cost_ = lethal_cost;
+    neutral_cost_ = neutral_cost;
+    factor_ = factor;
+    unknown_ = unknown;
+  }
+
+  bool LandmarkHeuristic::needsBuild(unsigned long version)
+  {
+    boost::mutex::scoped_lock lock(lock_);
+    if(version != latest_version_)
+    {
+      // a table of another map may overestimate on this one
+      latest_version_ = version;
+      if(table_ && table_->getVersion() != version)
+        table_.reset();
+    }
+    return version != 0 && !building_ && built_version_ != version;
+  }
+
+  void LandmarkHeuristic::build(std::vector< unsigned char >& costs, int nx,
+                                int ny, unsigned long version)
+  {
+    boost::mutex::scoped_lock lock(lock_);
+    if(building_)
+      return;
+
+    // the last build has returned, its thread only has to be collected
+    build_thread_.join();
+
+    costs_.swap(costs);
+    nx_ = nx;
+    ny_ = ny;
+    built_version_ = version;
+    building_ = true;
+    build_thread_ = boost::thread(
+        boost::bind(&LandmarkHeuristic::buildTable, this));
+  }
+
+  LandmarkTablePtr LandmarkHeuristic::getTable()
+  {
+    boost::mutex::scoped_lock lock(lock_);
+    return table_;
+  }
+
+  unsigned long LandmarkHeuristic::checksum(int count)
+  {
+    // FNV-1a over the map and everything the potentials depend on
+    unsigned int hash = 2166136261U;
+    int parameters[] = {nx_, ny_, count, compact_ ? 1 : 0, lethal_cost_,
+        neutral_cost_, (int)(factor_ * 1000), unknown_ ? 1 : 0};
+    const unsigned char* bytes = (const unsigned char*)parameters;
+    for(unsigned int i = 0; i < sizeof(parameters); i++)
+    {
+      hash ^= bytes[i];
+      hash *= 16777619U;
+    }
+    for(unsigned int i = 0; i < costs_.size(); i++)
+    {
+      hash ^= costs_[i];
+      hash *= 16777619U;
+    }
+    return hash;
+  }
+
+  void LandmarkHeuristic::buildTable()
+  {
+    unsigned long version;
+    {
+      boost::mutex::scoped_lock lock(lock_);
+      version = built_version_;
+    }
+
+    int ns = nx_ * ny_;
+    int count = count_;
+    unsigned long cell_bytes = (unsigned long)ns * (compact_ ? sizeof(unsigned short) : sizeof(float));
+    if(cell_bytes > 0 && cell_bytes * count > max_bytes_)
+      count = max_bytes_ / cell_bytes;
+
+    LandmarkTable* table = NULL;
+    if(count > 0)
+    {
+      unsigned long sum = checksum(count);
+      if(!file_.empty())
+        table = LandmarkTable::load(file_, sum, nx_, ny_, count, compact_,
+                                    version);
+
+      if(table == NULL)
+      {
+        // the traversal cost of Expander, with the map edge closed
+        terrain_.resize(ns);
+        for(int n = 0; n < ns; n++)
+        {
+          float c = costs_[n];
+          if(c < lethal_cost_ - 1 || (unknown_ && c == 255))
+            terrain_[n] = std::min(c * factor_ + neutral_cost_,
+                                   (float)lethal_cost_ - 1);
+          else
+            terrain_[n] = lethal_cost_;
+        }
+        for(int x = 0; x < nx_; x++)
+          terrain_[x] = terrain_[(ny_ - 1) * nx_ + x] = lethal_cost_;
+        for(int y = 0; y < ny_; y++)
+          terrain_[y * nx_] = terrain_[y * nx_ + nx_ - 1] = lethal_cost_;
+
+        p_calc_->setSize(nx_, ny_);
+        positions_.resize(ns);
+        std::vector< float > field(ns);
+        std::vector< float > nearest(ns, POT_HIGH);
+        table = new LandmarkTable(nx_, ny_, count, compact_, version);
+
+        // the first landmark is the cell farthest from the passable cell
+        // nearest the map center, each next one the cell farthest from all
+        // landmarks so far
+        int source = -1;
+        long best = -1;
+        for(int n = 0; n < ns; n++)
+        {
+          if(terrain_[n] >= lethal_cost_)
+            continue;
+          long dx = n % nx_ - nx_ / 2, dy = n / nx_ - ny_ / 2;
+          if(best < 0 || dx * dx + dy * dy < best)
+          {
+            best = dx * dx + dy * dy;
+            source = n;
+          }
+        }
+
+        bool ok = source >= 0 && propagate(source, &field[0]);
+        int l = 0;
+        while(ok && l < count)
+        {
+          std::vector< float >& distances = l == 0 ? field : nearest;
+          int farthest = -1;
+          for(int n = 0; n < ns; n++)
+          {
+            if(distances[n] < POT_HIGH && (farthest < 0 || distances[n] > distances[farthest]))
+              farthest = n;
+          }
+          if(farthest < 0 || distances[farthest] <= 0)
+            break;
+
+          ok = propagate(farthest, &field[0]);
+          if(!ok)
+            break;
+          table->setPotentials(l++, farthest, &field[0]);
+          for(int n = 0; n < ns; n++)
+            nearest[n] = std::min(nearest[n], field[n]);
+        }
+
+        if(!ok || l < count)
+        {
+          // stopped, or fewer distinct cells than landmarks
+          delete table;
+          table = NULL;
+        }
+        else if(!file_.empty())
+        {
+          table->save(file_, sum);
+        }
+      }
+    }
+
+    if(table != NULL)
+      NS_NaviCommon::console.debug("Landmark tables ready: %d landmarks on %d x %d cells",
+                                   count, nx_, ny_);
+    else if(!stop_)
+      printf("No landmark tables for the static map, A* keeps its own heuristic.\n");
+
+    boost::mutex::scoped_lock lock(lock_);
+    if(table != NULL && version == latest_version_)
+      table_.reset(table);
+    else
+      delete table;
+    building_ = false;
+  }
+
+  bool LandmarkHeuristic::propagate(int source, float* field)
+  {
+    std::fill(field, field + nx_ * ny_, POT_HIGH);
+    queue_.reset(&positions_[0]);
+    field[source] = 0;
+    queue_.push(source, 0);
+
+    unsigned long expanded = 0;
+    while(!queue_.empty())
+    {
+      if((++expanded & 0xffff) == 0 && stop_)
+        return false;
+
+      // terrain is lethal along the map edge, so the neighbors of every
+      // queued cell are on the map
+      int n = queue_.pop();
+      reach(field, n + 1);
+      reach(field, n - 1);
+      reach(field, n + nx_);
+      reach(field, n - nx_);
+    }
+    return true;
+  }
+
+} //end namespace global_planner
@@ -0,0 +1,242 @@
+#ifndef _LANDMARKS_H_
+#define _LANDMARKS_H_
+
+#include <math.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "Expander.h"
+#include "IndexedHeap.h"
+
+namespace NS_Planner
+{
+
+  /**
+   * @class LandmarkTable
+   * @brief Potentials of every cell from a few landmark cells, for the ALT heuristic
+   *
+   * By the triangle inequality, the potential between two cells is at least
+   * the difference of their potentials from any landmark. The values of a
+   * cell are stored next to each other, either as floats or compacted to
+   * 16 bits with a scale per landmark. A table does not change once built.
+   */
+  class LandmarkTable
+  {
+  public:
+    LandmarkTable(int nx, int ny, int count, bool compact,
+                  unsigned long version);
+
+    int getSizeX() const
+    {
+      return nx_;
+    }
+
+    int getSizeY() const
+    {
+      return ny_;
+    }
+
+    int getCount() const
+    {
+      return count_;
+    }
+
+    /**
+     * @brief Version of the static map the table was built for
+     */
+    unsigned long getVersion() const
+    {
+      return version_;
+    }
+
+    /**
+     * @brief Lower bound of the potential between cells n and goal, 0 if no landmark reaches both
+     */
+    inline float lowerBound(int n, int goal) const
+    {
+      float bound = 0;
+      if(compact_)
+      {
+        const unsigned short* a = &compact_values_[n * count_];
+        const unsigned short* b = &compact_values_[goal * count_];
+        for(int l = 0; l < count_; l++)
+        {
+          if(a[l] == UNREACHED || b[l] == UNREACHED)
+            continue;
+          // each value is rounded by up to half a step
+          int steps = abs((int)a[l] - (int)b[l]) - 1;
+          if(steps > 0 && steps * scales_[l] > bound)
+            bound = steps * scales_[l];
+        }
+      }
+      else
+      {
+        const float* a = &values_[n * count_];
+        const float* b = &values_[goal * count_];
+        for(int l = 0; l < count_; l++)
+        {
+          if(a[l] >= POT_HIGH || b[l] >= POT_HIGH)
+            continue;
+          float difference = fabs(a[l] - b[l]);
+          if(difference > bound)
+            bound = difference;
+        }
+      }
+      return bound;
+    }
+
+    /**
+     * @brief Store the potentials from landmark l at cell, POT_HIGH where it is not reached
+     */
+    void
+    setPotentials(int l, int cell, const float* potential);
+
+    /**
+     * @brief Write the table to file, tagged with checksum
+     */
+    bool
+    save(const std::string& file, unsigned long checksum) const;
+
+    /**
+     * @brief Read a table saved with the same checksum and layout
+     * @return NULL if the file is missing or does not match
+     */
+    static LandmarkTable*
+    load(const std::string& file, unsigned long checksum, int nx, int ny,
+         int count, bool compact, unsigned long version);
+
+  private:
+    enum
+    {
+      UNREACHED = 65535
+    };
+
+    int nx_, ny_, count_;
+    bool compact_;
+    unsigned long version_;
+    std::vector< int > cells_; ///< Cell of each landmark
+    std::vector< float > scales_; ///< Potential of one compact step, per landmark
+    std::vector< unsigned short > compact_values_; ///< cells x landmarks, when compact_
+    std::vector< float > values_; ///< cells x landmarks, otherwise
+  };
+
+  typedef boost::shared_ptr< const LandmarkTable > LandmarkTablePtr;
+
+  /**
+   * @class LandmarkHeuristic
+   * @brief Builds the landmark tables of the static map in the background
+   *
+   * The tables are calculated on the static map only, with the cost model of
+   * Expander and the planner's own PotentialCalculator. Every other layer
+   * only adds cost, so the bound holds on the planned costmap too, up to the
+   * interpolation error of the calculator. Once the static map changes, its
+   * old table is dropped until the new one is ready.
+   */
+  class LandmarkHeuristic
+  {
+  public:
+    /**
+     * @param p_calc Calculator for the background thread only, owned from now on
+     * @param count Landmarks wanted, fewer are used when the tables would pass max_bytes
+     * @param compact Store 16 bit values instead of floats
+     * @param file Where tables are saved and loaded from, not persisted if empty
+     */
+    LandmarkHeuristic(PotentialCalculator* p_calc, int count, bool compact,
+                      unsigned long max_bytes, const std::string& file);
+
+    ~LandmarkHeuristic();
+
+    /**
+     * @brief Set the cost model of Expander
+     */
+    void
+    setCosts(unsigned char lethal_cost, unsigned char neutral_cost,
+             float factor, bool unknown);
+
+    /**
+     * @brief Note the current static map version
+     * @return True if a table has to be built for it and no build is running
+     */
+    bool
+    needsBuild(unsigned long version);
+
+    /**
+     * @brief Start building the table of a static map in the background, costs are swapped out
+     */
+    void
+    build(std::vector< unsigned char >& costs, int nx, int ny,
+          unsigned long version);
+
+    /**
+     * @brief The table of the current static map, empty while there is none
+     */
+    LandmarkTablePtr
+    getTable();
+
+  private:
+    void
+    buildTable();
+
+    /**
+     * @brief Potentials of all cells reachable from source in field
+     * @return False if the build was stopped
+     */
+    bool
+    propagate(int source, float* field);
+
+    inline void reach(float* field, int m)
+    {
+      unsigned char cost = terrain_[m];
+      if(cost >= lethal_cost_)
+        return;
+      float pot = p_calc_->calculatePotential(field, cost, m);
+      if(pot >= field[m])
+        return;
+      if(field[m] < POT_HIGH)
+      {
+        // expanded cells are final
+        if(positions_[m] < 0)
+          return;
+        field[m] = pot;
+        queue_.decrease(m, pot);
+        return;
+      }
+      field[m] = pot;
+      queue_.push(m, pot);
+    }
+
+    unsigned long
+    checksum(int count);
+
+    PotentialCalculator* p_calc_;
+    int count_;
+    bool compact_;
+    unsigned long max_bytes_;
+    std::string file_;
+    unsigned char lethal_cost_, neutral_cost_;
+    float factor_;
+    bool unknown_;
+
+    boost::mutex lock_; ///< Guards table_, latest_version_, built_version_ and building_
+    LandmarkTablePtr table_;
+    unsigned long latest_version_; ///< Static map version last passed to needsBuild()
+    unsigned long built_version_; ///< Static map version of the last build started
+    bool building_;
+    volatile bool stop_;
+    boost::thread build_thread_;
+
+    // only used by the build thread
+    std::vector< unsigned char > costs_;
+    std::vector< unsigned char > terrain_; ///< Traversal cost of each cell, lethal_cost_ if it can not be entered
+    int nx_, ny_;
+    IndexedHeap queue_;
+    std::vector< int > positions_;
+  };
+
+} //end namespace global_planner
+#endif
@@ -2,6 +2,7 @@
 #include <Geometry/Angles.h>
 
 #include <math.h>
+#include <algorithm>
 
 #include <DataSet/DataType/PoseStamped.h>
 #include <Transform/DataTypes.h>
@@ -26,6 +27,10 @@ namespace NS_Planner
       std::vector< NS_DataType::PoseStamped >& path)
   {
     int n = path.size();
+    // an empty or single pose plan has no direction to take
+    if(n < 2)
+      return;
+
     switch(omode_)
     {
       case FORWARD:
@@ -44,7 +49,8 @@ namespace NS_Planner
           pointToNext(path, i);
         }
 
-        int i = n - 3;
+        // plans of few waypoints may have no pose before the last two
+        int i = std::max(n - 3, 0);
         double last = getYaw(path[i]);
         while(i > 0)
         {
@@ -86,7 +92,7 @@ namespace NS_Planner
     double increment = diff / (end_index - start_index);
     for(int i = start_index; i <= end_index; i++)
     {
-      double angle = start_yaw + increment * i;
+      double angle = start_yaw + increment * (i - start_index);
       set_angle(&path[i], angle);
     }
   }
@@ -22,6 +22,10 @@ namespace NS_Planner
     {
     }
 
+    virtual ~OrientationFilter()
+    {
+    }
+
     virtual void
     processPath(const NS_DataType::PoseStamped& start,
                 std::vector< NS_DataType::PoseStamped >& path);
@@ -0,0 +1,117 @@
+#include "PlannerWorkspace.h"
+#include "Expander.h"
+#include <algorithm>
+#include <string.h>
+#include <limits.h>
+
+namespace NS_Planner
+{
+
+  PlannerWorkspace::PlannerWorkspace()
+      : nx_(0), ny_(0), ns_(0), capacity_(0), potential_(NULL), gradx_(NULL), grady_(NULL),
+        cell_index_(NULL), cell_parent_(NULL), marks_(NULL), generation_(0),
+        potential_generation_(1)
+  {
+  }
+
+  PlannerWorkspace::~PlannerWorkspace()
+  {
+    release();
+  }
+
+  void PlannerWorkspace::release()
+  {
+    delete[] potential_;
+    delete[] gradx_;
+    delete[] grady_;
+    delete[] cell_index_;
+    delete[] cell_parent_;
+    delete[] marks_;
+
+    potential_ = gradx_ = grady_ = NULL;
+    cell_index_ = cell_parent_ = NULL;
+    marks_ = NULL;
+  }
+
+  bool PlannerWorkspace::setSize(int nx, int ny)
+  {
+    if(nx == nx_ && ny == ny_ && marks_ != NULL)
+      return false;
+
+    nx_ = nx;
+    ny_ = ny;
+    ns_ = nx * ny;
+
+    // nothing is known of the potential in the new layout
+    potential_rows_.assign(ny_, potential_generation_);
+
+    // stale stamps of another layout are below the next generation, so
+    // marks are only cleared when they are new
+    if(ns_ <= capacity_)
+      return true;
+
+    release();
+    capacity_ = ns_;
+
+    potential_ = new float[ns_];
+    gradx_ = new float[ns_];
+    grady_ = new float[ns_];
+    cell_index_ = new int[ns_];
+    cell_parent_ = new int[ns_];
+
+    // the only clearing the stamps ever need, until the generation wraps
+    marks_ = new unsigned int[ns_];
+    memset(marks_, 0, ns_ * sizeof(unsigned int));
+    generation_ = 0;
+
+    return true;
+  }
+
+  unsigned int PlannerWorkspace::nextGeneration()
+  {
+    if(generation_ == UINT_MAX)
+    {
+      memset(marks_, 0, capacity_ * sizeof(unsigned int));
+      generation_ = 0;
+    }
+    return ++generation_;
+  }
+
+  void PlannerWorkspace::resetPotential(float* potential)
+  {
+    if(potential != potential_)
+    {
+      std::fill(potential, potential + ns_, POT_HIGH);
+      return;
+    }
+
+    for(int y = 0; y < ny_; y++)
+    {
+      if(potential_rows_[y] == potential_generation_)
+        std::fill(potential + y * nx_, potential + (y + 1) * nx_, POT_HIGH);
+    }
+
+    // a new generation leaves every row unmarked
+    if(potential_generation_ == UINT_MAX)
+    {
+      potential_rows_.assign(ny_, 0);
+      potential_generation_ = 0;
+    }
+    potential_generation_++;
+  }
+
+  void PlannerWorkspace::markPotential(float* potential, int begin, int end)
+  {
+    if(potential != potential_)
+      return;
+
+    begin = std::max(begin, 0);
+    end = std::min(end, ns_);
+    if(begin >= end)
+      return;
+
+    for(int y = begin / nx_; y <= (end - 1) / nx_; y++)
+      potential_rows_[y] = potential_generation_;
+  }
+
+} //end namespace global_planner
@@ -0,0 +1,124 @@
+#ifndef _PLANNER_WORKSPACE_H_
+#define _PLANNER_WORKSPACE_H_
+
+#include <vector>
+
+namespace NS_Planner
+{
+
+  /**
+   * @class PlannerWorkspace
+   * @brief Per-cell arrays shared by the expander and the traceback of one planner
+   *
+   * The arrays are only reallocated when a map has more cells than any
+   * before, smaller maps such as planning windows reuse them. Per-search
+   * flags are stamped with a generation, so a new search starts by taking a
+   * new generation instead of clearing the whole map. The rows of the
+   * potential array are stamped the same way when a search writes them, and
+   * only those rows are cleared for the next search.
+   */
+  class PlannerWorkspace
+  {
+  public:
+    PlannerWorkspace();
+    ~PlannerWorkspace();
+
+    /**
+     * @brief Make the arrays fit a nx x ny map
+     * @return true if the size changed, the content of the arrays is undefined then
+     */
+    bool
+    setSize(int nx, int ny);
+
+    int getSizeX() const
+    {
+      return nx_;
+    }
+
+    int getSizeY() const
+    {
+      return ny_;
+    }
+
+    float* getPotential()
+    {
+      return potential_;
+    }
+
+    float* getGradX()
+    {
+      return gradx_;
+    }
+
+    float* getGradY()
+    {
+      return grady_;
+    }
+
+    /**
+     * @brief Per-cell integers for the search, such as heap positions, never cleared
+     */
+    int* getCellIndex()
+    {
+      return cell_index_;
+    }
+
+    /**
+     * @brief Per-cell parent cells for searches that keep a search tree, never cleared
+     */
+    int* getCellParent()
+    {
+      return cell_parent_;
+    }
+
+    /**
+     * @brief Per-cell generation stamps, a cell is marked if its stamp equals the current generation
+     */
+    unsigned int* getMarks()
+    {
+      return marks_;
+    }
+
+    /**
+     * @brief Start a new generation, unmarking every cell
+     */
+    unsigned int
+    nextGeneration();
+
+    /**
+     * @brief Set every cell of potential to POT_HIGH for a new search
+     *
+     * Of the workspace's own potential array, only the rows marked since its
+     * last reset are filled, any other array is filled whole.
+     */
+    void
+    resetPotential(float* potential);
+
+    /**
+     * @brief Mark the rows of cells [begin, end) of potential as written since its last reset, if it is the workspace's own array
+     */
+    void
+    markPotential(float* potential, int begin, int end);
+
+  private:
+    void
+    release();
+
+    int nx_, ny_, ns_;
+    int capacity_; ///< Cells the arrays have room for
+
+    float* potential_;
+    float* gradx_;
+    float* grady_;
+    int* cell_index_;
+    int* cell_parent_;
+
+    unsigned int* marks_;
+    unsigned int generation_; ///< 0 is never used, so zeroed stamps are unmarked
+
+    std::vector< unsigned int > potential_rows_; ///< Per row, the potential generation it was last written in
+    unsigned int potential_generation_; ///< Rows stamped with it hold potentials, the others only POT_HIGH
+  };
+
+} //end namespace global_planner
+#endif
@@ -2,6 +2,7 @@
 #define _POTENTIAL_CALCULATOR_H_
 
 #include <algorithm>
+#include <math.h>
 
 #include <Console/Console.h>
 
@@ -16,10 +17,13 @@ namespace NS_Planner
       setSize(nx, ny);
     }
 
+    virtual ~PotentialCalculator()
+    {
+    }
+
     virtual float calculatePotential(float* potential, unsigned char cost,
                                      int n, float prev_potential = -1)
     {
-      printf("calculatePotential running...\n");
       if(prev_potential < 0)
       {
         // get min of neighbors
@@ -27,10 +31,20 @@ namespace NS_Planner
             min_v = std::min(potential[n - nx_], potential[n + nx_]);
         prev_potential = std::min(min_h, min_v);
       }
-      printf("Finish calculatPotential...\n");
       return prev_potential + cost;
     }
 
+    /**
+     * @brief Lowest potential a wave of unit cell cost gains over dx, dy cells
+     *
+     * Neighbors update each other along the grid axes, so it is the
+     * Manhattan distance.
+     */
+    virtual float unitDistance(float dx, float dy)
+    {
+      return fabs(dx) + fabs(dy);
+    }
+
     /**
      * @brief  Sets or resets the size of the map
      * @param nx The x size of the map
@@ -1,6 +1,7 @@
 #ifndef _QUADRATIC_CALCULATOR_H_
 #define _QUADRATIC_CALCULATOR_H_
 #include<vector>
+#include <math.h>
 
 #include "PotentialCalculator.h"
 
@@ -18,6 +19,15 @@ namespace NS_Planner
     float
     calculatePotential(float* potential, unsigned char cost, int n,
                        float prev_potential);
+
+    /**
+     * @brief The planar wave update travels at unit speed in every direction,
+     * it never falls below the Euclidean distance
+     */
+    float unitDistance(float dx, float dy)
+    {
+      return sqrtf(dx * dx + dy * dy);
+    }
   };
 
 } //end namespace global_planner
@@ -0,0 +1,282 @@
+#include "ThetaStar.h"
+#include <algorithm>
+#include <stdlib.h>
+
+namespace NS_Planner
+{
+
+  ThetaStarExpansion::ThetaStarExpansion(PotentialCalculator* p_calc, int nx,
+                                         int ny)
+      : Expander(p_calc, nx, ny), parent_(NULL), closed_(NULL),
+        closed_generation_(0), start_i_(0), goal_x_(0), goal_y_(0),
+        goal_i_(0), search_costs_(NULL), search_potential_(NULL), cycle_(0),
+        cycles_(0), max_queue_(0), queue_growths_(0)
+  {
+  }
+
+  ExpansionStats ThetaStarExpansion::getStats()
+  {
+    ExpansionStats stats;
+    stats.cells_visited = cells_visited_;
+    stats.max_queue = max_queue_;
+    stats.queue_growths = queue_growths_;
+    return stats;
+  }
+
+  bool ThetaStarExpansion::calculatePotentials(unsigned char* costs,
+                                               double start_x, double start_y,
+                                               double end_x, double end_y,
+                                               int cycles, float* potential)
+  {
+    SearchState state = startSearch(costs, start_x, start_y, end_x, end_y,
+                                    cycles, potential);
+    while(state == SEARCH_IN_PROGRESS)
+      state = resumeSearch();
+    return state == SEARCH_FOUND;
+  }
+
+  Expander::SearchState ThetaStarExpansion::startSearch(unsigned char* costs,
+                                                        double start_x,
+                                                        double start_y,
+                                                        double end_x,
+                                                        double end_y,
+                                                        int cycles,
+                                                        float* potential)
+  {
+    cells_visited_ = 0;
+    max_queue_ = queue_growths_ = 0;
+
+    // heap positions and parents are only read for cells the search reached
+    queue_.reset(workspace_->getCellIndex());
+    parent_ = workspace_->getCellParent();
+    closed_ = workspace_->getMarks();
+    closed_generation_ = workspace_->nextGeneration();
+
+    // any cell may be written, the next search clears them all
+    workspace_->resetPotential(potential);
+    workspace_->markPotential(potential, 0, ns_);
+
+    // lines cross many cells, their costs are looked up instead
+    for(int v = 0; v < 256; v++)
+    {
+      unsigned char c = v;
+      cell_costs_[v] = getCost(&c, 0);
+    }
+
+    goal_x_ = (int)end_x;
+    goal_y_ = (int)end_y;
+    goal_i_ = toIndex(end_x, end_y);
+
+    start_i_ = toIndex(start_x, start_y);
+    potential[start_i_] = 0;
+    parent_[start_i_] = ~start_i_;
+    queue_.push(start_i_, heuristic(start_i_));
+
+    search_costs_ = costs;
+    search_potential_ = potential;
+    cycle_ = 0;
+    cycles_ = cycles;
+    return resumeSearch();
+  }
+
+  Expander::SearchState ThetaStarExpansion::resumeSearch()
+  {
+    unsigned char* costs = search_costs_;
+    float* potential = search_potential_;
+
+    startSlice();
+    for(; !queue_.empty() && cycle_ < cycles_; cycle_++)
+    {
+      if(sliceOver())
+        return SEARCH_IN_PROGRESS;
+
+      if(queue_.size() > max_queue_)
+        max_queue_ = queue_.size();
+
+      int s = queue_.pop();
+      float assumed = potential[s];
+      setVertex(costs, potential, s);
+      if(potential[s] > assumed)
+      {
+        // its path costs more than it was queued with, it waits for its
+        // turn again
+        if(potential[s] < POT_HIGH)
+          queue_.push(s, potential[s] + heuristic(s));
+        continue;
+      }
+
+      closed_[s] = closed_generation_;
+      cells_visited_++;
+
+      if(s == goal_i_)
+        return SEARCH_FOUND;
+
+      int x = s % nx_, y = s / nx_;
+      for(int dy = -1; dy <= 1; dy++)
+      {
+        for(int dx = -1; dx <= 1; dx++)
+        {
+          if((dx == 0 && dy == 0) || x + dx < 0 || x + dx >= nx_ || y + dy < 0 || y + dy >= ny_)
+            continue;
+          // no diagonal step past a lethal corner
+          if(dx != 0 && dy != 0 && (getCost(costs, s + dx) >= lethal_cost_ || getCost(
+              costs, s + dy * nx_) >= lethal_cost_))
+            continue;
+          add(costs, potential, s, s + dx + dy * nx_);
+        }
+      }
+    }
+
+    return SEARCH_FAILED;
+  }
+
+  void ThetaStarExpansion::add(unsigned char* costs, float* potential, int s,
+                               int next)
+  {
+    if(closed_[next] == closed_generation_ || getCost(costs, next) >= lethal_cost_)
+      return;
+
+    // the line is only walked once next is expanded
+    int p = parentOf(parent_[s]);
+    float pot = potential[p] + distance(next % nx_ - p % nx_, next / nx_ - p / nx_);
+    if(pot >= potential[next])
+      return;
+
+    bool open = potential[next] < POT_HIGH;
+    if(open && parent_[next] < 0)
+    {
+      // next waits with the true cost of its line already, only a line
+      // that really is cheaper may replace it
+      if(~parent_[next] == p)
+        return;
+      pot = potential[p] + lineCost(costs, p, next);
+      if(pot >= potential[next])
+        return;
+      potential[next] = pot;
+      parent_[next] = ~p;
+      queue_.decrease(next, pot + heuristic(next));
+      return;
+    }
+
+    potential[next] = pot;
+    parent_[next] = p;
+    if(open)
+    {
+      queue_.decrease(next, pot + heuristic(next));
+      return;
+    }
+
+    if(queue_.size() == queue_.capacity())
+      queue_growths_++;
+    queue_.push(next, pot + heuristic(next));
+  }
+
+  void ThetaStarExpansion::setVertex(unsigned char* costs, float* potential,
+                                     int s)
+  {
+    if(parent_[s] < 0)
+      return;
+
+    int p = parent_[s];
+    float pot = potential[p] + lineCost(costs, p, s);
+    if(pot > potential[s])
+    {
+      // blocked or through costlier cells than assumed, a step from an
+      // expanded neighbor may do better
+      int x = s % nx_, y = s / nx_;
+      for(int dy = -1; dy <= 1; dy++)
+      {
+        for(int dx = -1; dx <= 1; dx++)
+        {
+          if((dx == 0 && dy == 0) || x + dx < 0 || x + dx >= nx_ || y + dy < 0 || y + dy >= ny_)
+            continue;
+          int n = s + dx + dy * nx_;
+          if(closed_[n] != closed_generation_)
+            continue;
+          float step = potential[n] + lineCost(costs, n, s);
+          if(step < pot)
+          {
+            pot = step;
+            p = n;
+          }
+        }
+      }
+    }
+
+    parent_[s] = ~p;
+    potential[s] = pot;
+  }
+
+  float ThetaStarExpansion::lineCost(unsigned char* costs, int a, int b)
+  {
+    int dx = b % nx_ - a % nx_, dy = b / nx_ - a / nx_;
+    int abs_dx = abs(dx), abs_dy = abs(dy);
+    int offset_dx = dx > 0 ? 1 : -1;
+    int offset_dy = dy > 0 ? nx_ : -nx_;
+
+    // steps go along the longer axis, the shorter one follows them
+    int steps = abs_dx, minor = abs_dy, offset_a = offset_dx, offset_b = offset_dy;
+    if(abs_dy > abs_dx)
+    {
+      steps = abs_dy;
+      minor = abs_dx;
+      offset_a = offset_dy;
+      offset_b = offset_dx;
+    }
+    if(steps == 0)
+      return 0;
+
+    // cost above the neutral cost of the cells crossed
+    float extra = 0;
+    int error = steps / 2;
+    int n = a;
+    for(int i = 0; i < steps; i++)
+    {
+      n += offset_a;
+      error += minor;
+      if(error >= steps)
+      {
+        if(cell_costs_[costs[n]] >= lethal_cost_ || cell_costs_[costs[n - offset_a + offset_b]] >= lethal_cost_)
+          return POT_HIGH;
+        n += offset_b;
+        error -= steps;
+      }
+
+      float c = cell_costs_[costs[n]];
+      if(c >= lethal_cost_)
+        return POT_HIGH;
+      extra += c - neutral_cost_;
+    }
+
+    // each cell crossed takes an equal share of the length
+    return distance(dx, dy) + extra * (float)hypot(dx, dy) / steps;
+  }
+
+  bool ThetaStarExpansion::getWaypoints(
+      double spacing, std::vector< std::pair< float, float > >& path)
+  {
+    path.clear();
+    if(closed_ == NULL || closed_[goal_i_] != closed_generation_)
+      return false;
+
+    int c = goal_i_;
+    path.push_back(std::make_pair((float)(c % nx_), (float)(c / nx_)));
+    for(int count = 0; c != start_i_; count++)
+    {
+      if(count > ns_)
+        return false;
+
+      int p = parentOf(parent_[c]);
+      float x = c % nx_, y = c / nx_;
+      float dx = p % nx_ - x, dy = p / nx_ - y;
+      int pieces = 1;
+      if(spacing > 0)
+        pieces = std::max((int)ceil(hypot(dx, dy) / spacing), 1);
+      for(int k = 1; k <= pieces; k++)
+        path.push_back(std::make_pair(x + dx * k / pieces, y + dy * k / pieces));
+      c = p;
+    }
+    return true;
+  }
+
+} //end namespace global_planner
@@ -0,0 +1,116 @@
+#ifndef _THETA_STAR_H_
+#define _THETA_STAR_H_
+
+#include <math.h>
+#include <vector>
+
+#include "Expander.h"
+#include "IndexedHeap.h"
+
+namespace NS_Planner
+{
+
+  /**
+   * @class ThetaStarExpansion
+   * @brief Any-angle search (lazy Theta*) whose paths are straight lines between few waypoints
+   *
+   * Cells are searched on the 8-connected grid like A*, but a cell takes
+   * the parent of the cell it was reached from, so the path to it is one
+   * straight line from there. The line is only walked when the cell is
+   * expanded: if it crosses a lethal cell, cuts a lethal corner or costs more
+   * than it was assumed to, the cheapest step from an expanded neighbor is
+   * taken where it is better. A line costs the traversal cost of every cell
+   * it crosses, so lines through inflated cells are only taken where they
+   * still pay off.
+   *
+   * The potential of every reached cell is the cost of its line path.
+   * GradientPath can not follow it, the path is taken from getWaypoints().
+   */
+  class ThetaStarExpansion: public Expander
+  {
+  public:
+    ThetaStarExpansion(PotentialCalculator* p_calc, int nx, int ny);
+
+    bool
+    calculatePotentials(unsigned char* costs, double start_x, double start_y,
+                        double end_x, double end_y, int cycles,
+                        float* potential);
+
+    SearchState
+    startSearch(unsigned char* costs, double start_x, double start_y,
+                double end_x, double end_y, int cycles, float* potential);
+
+    SearchState
+    resumeSearch();
+
+    /**
+     * @brief Waypoints of the path of the last search from the goal back to the start, in cells
+     * @param spacing Segments longer than this many cells are cut in equal pieces, 0 keeps only the turns
+     * @return False if the last search did not reach its goal
+     */
+    bool
+    getWaypoints(double spacing, std::vector< std::pair< float, float > >& path);
+
+    ExpansionStats
+    getStats();
+  private:
+    /**
+     * @brief Parent of a cell, whose entry is the bitwise not of it once the line from it was walked
+     */
+    inline int parentOf(int entry)
+    {
+      return entry < 0 ? ~entry : entry;
+    }
+
+    /**
+     * @brief Cost of the straight line from cell a to cell b, POT_HIGH if it is blocked
+     *
+     * The line is walked the way Costmap2D::raytraceLine() walks it, but stops
+     * at the first lethal cell. Where the line steps along both axes at once,
+     * the cell beside the corner it cuts may not be lethal either.
+     */
+    float
+    lineCost(unsigned char* costs, int a, int b);
+
+    /**
+     * @brief Walk the line from the parent of s, or take the best step from an expanded neighbor instead
+     */
+    void
+    setVertex(unsigned char* costs, float* potential, int s);
+
+    /**
+     * @brief Give next the parent of s, assuming the line from it crosses free cells only
+     */
+    void
+    add(unsigned char* costs, float* potential, int s, int next);
+
+    /**
+     * @brief Least cost of a line between two cells dx and dy apart, the one through free cells
+     */
+    inline float distance(int dx, int dy)
+    {
+      return neutral_cost_ * hypot(dx, dy);
+    }
+
+    inline float heuristic(int i)
+    {
+      return distance(i % nx_ - goal_x_, i / nx_ - goal_y_);
+    }
+
+    IndexedHeap queue_; /**< open cells keyed by potential plus distance to the goal */
+    int* parent_; /**< cell each cell has a line from, bitwise not of it once the line was walked */
+    unsigned int* closed_; /**< expanded cells, stamped with closed_generation_ */
+    unsigned int closed_generation_;
+    int start_i_, goal_x_, goal_y_, goal_i_;
+    float cell_costs_[256]; /**< getCost() of each cost value, for the search running */
+
+    unsigned char* search_costs_; /**< search kept between slices */
+    float* search_potential_;
+    int cycle_, cycles_;
+
+    unsigned long max_queue_;
+    unsigned long queue_growths_;
+  };
+
+} //end namespace global_planner
+#endif
@@ -2,6 +2,7 @@
 #define _TRACEBACK_H_
 #include <vector>
 #include "PotentialCalculator.h"
+#include "PlannerWorkspace.h"
 
 namespace NS_Planner
 {
@@ -10,7 +11,7 @@ namespace NS_Planner
   {
   public:
     Traceback(PotentialCalculator* p_calc)
-        : p_calc_(p_calc)
+        : p_calc_(p_calc), workspace_(NULL)
     {
     }
 
@@ -31,10 +32,18 @@ namespace NS_Planner
     {
       lethal_cost_ = lethal_cost;
     }
+    /**
+     * @brief Set the workspace scratch arrays are borrowed from, it must fit the map size
+     */
+    void setWorkspace(PlannerWorkspace* workspace)
+    {
+      workspace_ = workspace;
+    }
   protected:
     int xs_, ys_;
     unsigned char lethal_cost_;
     PotentialCalculator* p_calc_;
+    PlannerWorkspace* workspace_;
   };
 
 } //end namespace global_planner
@@ -13,14 +13,26 @@
 #include "Algorithm/GradientPath.h"
 
 #include "Algorithm/Astar.h"
+#include "Algorithm/JumpPoint.h"
+#include "Algorithm/ThetaStar.h"
+#include "Algorithm/Incremental.h"
 #include "Algorithm/Dijkstra.h"
+#include "Algorithm/Landmarks.h"
+#include "Algorithm/FieldCache.h"
+
+#include "../../../CostMap/Layers/StaticLayer.h"
 
 #include <DataSet/DataType/OccupancyGrid.h>
 #include <Parameter/Parameter.h>
 
 #include <Console/Console.h>
+#include <Transform/DataTypes.h>
+#include <boost/bind.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
 using namespace std;
 
 /*
@@ -30,11 +42,38 @@ namespace NS_Planner
 {
 
   GlobalPlanner::GlobalPlanner()
+      : initialized_(false), planned_version_(0), planned_robot_x_(0),
+        planned_robot_y_(0), landmarks_(NULL), static_layer_(NULL),
+        dijkstra_(NULL), field_cache_(NULL), field_cache_version_(0),
+        plan_from_goal_(false), plan_from_waypoints_(false),
+        wave_(NULL), planned_cost_(POT_HIGH), lethal_cost_(253),
+        neutral_cost_(50), cost_factor_(3.0), theta_(NULL),
+        waypoint_spacing_(0), plan_slice_cells_(0),
+        plan_slice_time_(0), search_cancelled_(false),
+        search_timed_out_(false), astar_(NULL),
+        anytime_time_limit_(0), anytime_weight_(1), anytime_weight_step_(1),
+        plan_waiting_(false), stop_improving_(false), improve_pending_(false),
+        improving_(false), improve_goal_id_(0), improve_weight_(1),
+        has_improved_(false), goal_id_(0)
   {
   }
 
   GlobalPlanner::~GlobalPlanner()
   {
+    // a round still running gives up, as it does for a new plan
+    stop_improving_ = true;
+    plan_waiting_ = true;
+    improve_cond_.notify_one();
+    improve_thread_.join();
+
+    // stops a table build still running
+    delete landmarks_;
+    delete field_cache_;
+
+    // Dijkstra waves own worker threads, deleting them stops the workers
+    if(wave_ != dijkstra_)
+      delete wave_;
+    delete dijkstra_;
   }
 
   /*
@@ -83,7 +122,8 @@ namespace NS_Planner
        * PotentialCalculator、QuadraticCalculator
        */
 //		NS_NaviCommon::console.debug("After loading...");
-      if(parameter.getParameter("use_quadratic", 1) == 1)
+      bool use_quadratic = parameter.getParameter("use_quadratic", 1) == 1;
+      if(use_quadratic)
         p_calc_ = new QuadraticCalculator(cx, cy);
       else
         p_calc_ = new PotentialCalculator(cx, cy);
@@ -93,15 +133,42 @@ namespace NS_Planner
        * 获取 use_dijkstra 参数值，根据参数值创建 planner_ 实例，决定用 dijkstra 算法还是 A* 算法
        * Expander、Dijkstra、A*
        */
-      if(parameter.getParameter("use_dijkstra", 1) == 1)
+      AStarExpansion* astar = NULL;
+      // split Dijkstra blocks are slower than the serial update on a
+      // single core, so threads are only started where there are cores
+      int expansion_threads = parameter.getParameter("expansion_threads", 1);
+      int cores = boost::thread::hardware_concurrency();
+      if(cores > 0 && expansion_threads > cores)
+      {
+        printf("expansion_threads is %d, but there are %d cores, %d threads are used.\n",
+               expansion_threads, cores, cores);
+        expansion_threads = cores;
+      }
+      if(parameter.getParameter("use_jump_point", 0) == 1)
+      {
+        planner_ = new JumpPointExpansion(p_calc_, cx, cy);
+      }
+      else if(parameter.getParameter("use_theta_star", 0) == 1)
+      {
+        theta_ = new ThetaStarExpansion(p_calc_, cx, cy);
+        planner_ = theta_;
+      }
+      else if(parameter.getParameter("use_incremental", 0) == 1)
       {
-        DijkstraExpansion* de = new DijkstraExpansion(p_calc_, cx, cy);
-        de->setPreciseStart(true);
-        planner_ = de;
+        planner_ = new IncrementalExpansion(p_calc_, cx, cy);
+      }
+      else if(parameter.getParameter("use_dijkstra", 1) == 1)
+      {
+        dijkstra_ = new DijkstraExpansion(p_calc_, cx, cy);
+        dijkstra_->setPreciseStart(true);
+        dijkstra_->setThreads(expansion_threads);
+        planner_ = dijkstra_;
       }
       else
       {
-        planner_ = new AStarExpansion(p_calc_, cx, cy);
+        astar = new AStarExpansion(p_calc_, cx, cy);
+        astar->setWeight(parameter.getParameter("astar_weight", 1.0f));
+        planner_ = astar;
       }
 
 //		NS_NaviCommon::console.debug("After planner_ assignment");
@@ -114,6 +181,9 @@ namespace NS_Planner
       else
         path_maker_ = new GradientPath(p_calc_);
 
+      planner_->setWorkspace(&workspace_);
+      path_maker_->setWorkspace(&workspace_);
+
 //		NS_NaviCommon::console.debug("After path_maker_ assignment...");
 
       orientation_filter_ = new OrientationFilter();
@@ -144,6 +214,9 @@ namespace NS_Planner
       int neutral_cost = parameter.getParameter("neutral_cost", 50);
       double cost_factor = parameter.getParameter("cost_factor", 3.0f);
       int orientation_mode = parameter.getParameter("orientation_mode", 1);
+      lethal_cost_ = lethal_cost;
+      neutral_cost_ = neutral_cost;
+      cost_factor_ = cost_factor;
 
       planner_->setLethalCost(lethal_cost);
       path_maker_->setLethalCost(lethal_cost);
@@ -151,6 +224,82 @@ namespace NS_Planner
       planner_->setFactor(cost_factor);
       orientation_filter_->setMode(orientation_mode);
 
+      // batch queries run a Dijkstra wave, the planner's own if it is one
+      wave_ = dijkstra_;
+      if(wave_ == NULL)
+      {
+        wave_ = new DijkstraExpansion(p_calc_, cx, cy);
+        wave_->setPreciseStart(true);
+        wave_->setThreads(expansion_threads);
+        wave_->setWorkspace(&workspace_);
+        wave_->setHasUnknown(allow_unknown_);
+        wave_->setLethalCost(lethal_cost);
+        wave_->setNeutralCost(neutral_cost);
+        wave_->setFactor(cost_factor);
+      }
+
+      // fields rooted at recent goals, for Dijkstra
+      int field_cache_mb = parameter.getParameter("field_cache_mb", 0);
+      if(dijkstra_ != NULL && field_cache_mb > 0)
+        field_cache_ = new FieldCache((unsigned long)field_cache_mb * 1024 * 1024);
+
+      // landmark tables of the static map, for the A* heuristic
+      if(astar != NULL && parameter.getParameter("use_landmarks", 0) == 1)
+      {
+        std::vector< boost::shared_ptr< NS_CostMap::Layer > >* plugins =
+            costmap->getLayeredCostmap()->getPlugins();
+        for(unsigned int i = 0; i < plugins->size() && static_layer_ == NULL; i++)
+          static_layer_ = dynamic_cast< NS_CostMap::StaticLayer* >((*plugins)[i].get());
+
+        if(static_layer_ == NULL)
+        {
+          printf("The global costmap has no static layer, landmarks are not used.\n");
+        }
+        else
+        {
+          // the tables are built in their own thread, with their own calculator
+          PotentialCalculator* landmark_calc;
+          if(use_quadratic)
+            landmark_calc = new QuadraticCalculator(cx, cy);
+          else
+            landmark_calc = new PotentialCalculator(cx, cy);
+
+          unsigned long memory_mb = parameter.getParameter("landmark_memory_mb", 64);
+          landmarks_ = new LandmarkHeuristic(
+              landmark_calc, parameter.getParameter("landmark_count", 8),
+              parameter.getParameter("landmark_compact", 1) == 1,
+              memory_mb * 1024 * 1024,
+              parameter.getParameter("landmark_file", ""));
+          landmarks_->setCosts(lethal_cost, neutral_cost, cost_factor,
+                               allow_unknown_);
+          astar->setLandmarks(landmarks_);
+        }
+      }
+
+      // plans of any-angle search are lines between waypoints, long lines
+      // get points in between so the local planner finds one near the robot
+      waypoint_spacing_ = std::max(parameter.getParameter("waypoint_spacing", 0.5f), 0.0f);
+
+      // searches in slices, a new goal gives up the running one in between
+      plan_slice_cells_ = std::max(parameter.getParameter("plan_slice_cells", 0), 0);
+      plan_slice_time_ = std::max(parameter.getParameter("plan_slice_time", 0.02f), 0.0f);
+
+      // anytime mode, a first plan within the time limit, better ones later
+      anytime_time_limit_ = parameter.getParameter("anytime_time_limit", 0.0f);
+      anytime_weight_ = std::max(parameter.getParameter("anytime_weight", 5.0f), 1.0f);
+      anytime_weight_step_ = std::max(parameter.getParameter("anytime_weight_step", 1.0f), 0.01f);
+      if(anytime_time_limit_ > 0 && astar == NULL)
+      {
+        printf("Anytime planning needs A*, set use_dijkstra to 0, plans are made without a time limit.\n");
+        anytime_time_limit_ = 0;
+      }
+      if(anytime_time_limit_ > 0)
+      {
+        astar_ = astar;
+        improve_thread_ = boost::thread(
+            boost::bind(&GlobalPlanner::improvePlans, this));
+      }
+
       initialized_ = true;
     }
     else
@@ -164,7 +313,10 @@ namespace NS_Planner
                                std::vector< NS_DataType::PoseStamped >& plan)
   {
 //	NS_NaviCommon::console.debug("GlobalPlanner makePlan running...");
+    // a new plan goes before improving the last one
+    plan_waiting_ = true;
     boost::mutex::scoped_lock lock(mutex_);
+    plan_waiting_ = false;
 
 //	NS_NaviCommon::console.debug("After locking...");
 
@@ -175,9 +327,338 @@ namespace NS_Planner
       return false;
     }
 
+    if(astar_ == NULL)
+      return planOnSnapshot(start, goal, plan);
+
+    // the new goal replaces the one improved so far
+    {
+      boost::mutex::scoped_lock improved_lock(improved_lock_);
+      improved_plan_.clear();
+      has_improved_ = false;
+      improve_goal_id_ = ++goal_id_;
+    }
+
+    astar_->setWeight(anytime_weight_);
+    deadline_ = NS_NaviCommon::Time::now() + NS_NaviCommon::Duration(anytime_time_limit_);
+    bool found = planOnSnapshot(start, goal, plan);
+    deadline_ = NS_NaviCommon::Time();
+
+    improve_goal_ = goal;
+    if(found)
+      improve_plan_ = plan;
+    else
+      improve_plan_.clear();
+    if(!found && search_timed_out_)
+    {
+      // keep searching for a first plan without the time limit
+      improve_weight_ = anytime_weight_;
+      improve_pending_ = true;
+      printf("No plan within %.3f s, still searching in the background.\n",
+             anytime_time_limit_);
+    }
+    else
+    {
+      // a lower weight may also get a path out of a goal that was reached
+      // but not traced back to
+      improve_weight_ = std::max(anytime_weight_ - anytime_weight_step_, 1.0f);
+      improve_pending_ = anytime_weight_ > 1 && planned_cost_ < POT_HIGH;
+    }
+    improve_cond_.notify_one();
+    return found;
+  }
+
+  bool GlobalPlanner::planOnSnapshot(const NS_DataType::PoseStamped& start,
+                                     const NS_DataType::PoseStamped& goal,
+                                     std::vector< NS_DataType::PoseStamped >& plan)
+  {
     //clear the plan, just in case
     // 先把 plan 清空
     plan.clear();
+    planned_cost_ = POT_HIGH;
+    search_cancelled_ = search_timed_out_ = false;
+
+    // plan on a private copy of the latest snapshot, the costmap keeps
+    // updating meanwhile
+    NS_CostMap::CostmapSnapshotPtr snapshot = costmap->getSnapshot();
+    if(snapshot->getVersion() == 0)
+    {
+      printf("The costmap has not been published yet, unable to plan.\n");
+      return false;
+    }
+    const NS_CostMap::Costmap2D& full = snapshot->getCostmap();
+
+    // search a window around start and goal first, growing it while no
+    // path is found, fields kept between plans need the whole map
+    bool windowed = (planner_window_x_ > 0 || planner_window_y_ > 0) && !planner_->isIncremental() && field_cache_ == NULL;
+    if(!windowed)
+    {
+      planning_costmap_ = full;
+      return planOnCopy(snapshot->getVersion(), start, goal, plan);
+    }
+
+    double margin_x = planner_window_x_ > 0 ? planner_window_x_ : planner_window_y_;
+    double margin_y = planner_window_y_ > 0 ? planner_window_y_ : planner_window_x_;
+    while(true)
+    {
+      bool whole = !copyWindow(full, start, goal, margin_x, margin_y);
+      if(planOnCopy(snapshot->getVersion(), start, goal, plan) || whole)
+        return !plan.empty();
+      // a larger window will not be searched in time either
+      if(search_cancelled_ || search_timed_out_)
+        return false;
+
+      margin_x *= 2;
+      margin_y *= 2;
+      NS_NaviCommon::console.debug(
+          "No path in the planner window, growing its margin to %.2f x %.2f",
+          margin_x, margin_y);
+    }
+  }
+
+  void GlobalPlanner::improvePlans()
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    while(!stop_improving_)
+    {
+      if(improve_pending_ && improveCancelled())
+        improve_pending_ = false;
+
+      if(!improve_pending_ || preempted())
+      {
+        improve_cond_.timed_wait(
+            lock,
+            boost::get_system_time() + boost::posix_time::milliseconds(100));
+        continue;
+      }
+
+      // plan from where the robot is by now
+      NS_Transform::Stamped< NS_Transform::Pose > robot_pose;
+      if(!costmap->getRobotPose(robot_pose))
+      {
+        improve_pending_ = false;
+        continue;
+      }
+      NS_DataType::PoseStamped start;
+      NS_Transform::poseStampedTFToMsg(robot_pose, start);
+
+      float weight = improve_weight_;
+      std::vector< NS_DataType::PoseStamped > plan;
+      astar_->setWeight(weight);
+      improving_ = true;
+      bool found = planOnSnapshot(start, improve_goal_, plan);
+      improving_ = false;
+
+      // a new plan was asked for, the round is done again if it still counts
+      if(search_cancelled_)
+        continue;
+
+      // the plan handed out started where the robot was back then, both
+      // are costed from where it is now
+      float cost = POT_HIGH, improve_cost = POT_HIGH;
+      if(found)
+      {
+        NS_CostMap::CostmapSnapshotPtr snapshot = costmap->getSnapshot();
+        cost = planCost(snapshot->getCostmap(), start, plan);
+        improve_cost = planCost(snapshot->getCostmap(), start, improve_plan_);
+      }
+
+      if(found && (improve_plan_.empty() || cost < improve_cost))
+      {
+        NS_NaviCommon::console.debug(
+            "Anytime plan improved with A* weight %.2f, cost %.1f to %.1f",
+            weight, improve_cost, cost);
+        improve_plan_ = plan;
+        boost::mutex::scoped_lock improved_lock(improved_lock_);
+        // the goal may have been cancelled while the round ran
+        if(goal_id_ == improve_goal_id_)
+        {
+          improved_plan_.swap(plan);
+          has_improved_ = true;
+        }
+      }
+
+      if(weight <= 1)
+        improve_pending_ = false;
+      else
+        improve_weight_ = std::max(weight - anytime_weight_step_, 1.0f);
+    }
+  }
+
+  float GlobalPlanner::planCost(const NS_CostMap::Costmap2D& costs,
+                                const NS_DataType::PoseStamped& start,
+                                const std::vector< NS_DataType::PoseStamped >& plan)
+  {
+    if(plan.empty())
+      return POT_HIGH;
+
+    // the robot has moved along the plan, it goes on from the nearest pose
+    unsigned int first = 0;
+    double nearest = -1;
+    for(unsigned int i = 0; i < plan.size(); i++)
+    {
+      double dx = plan[i].pose.position.x - start.pose.position.x;
+      double dy = plan[i].pose.position.y - start.pose.position.y;
+      if(nearest < 0 || dx * dx + dy * dy < nearest)
+      {
+        nearest = dx * dx + dy * dy;
+        first = i;
+      }
+    }
+
+    unsigned int start_x, start_y;
+    if(!costs.worldToMap(start.pose.position.x, start.pose.position.y,
+                         start_x, start_y))
+      return POT_HIGH;
+
+    float cost = 0;
+    double x = start.pose.position.x, y = start.pose.position.y;
+    for(unsigned int i = first; i < plan.size(); i++)
+    {
+      // segments are sampled about once per cell, as the search steps
+      double dx = plan[i].pose.position.x - x, dy = plan[i].pose.position.y - y;
+      double cells = sqrt(dx * dx + dy * dy) / costs.getResolution();
+      int steps = std::max((int)ceil(cells), 1);
+      for(int k = 1; k <= steps; k++)
+      {
+        unsigned int mx, my;
+        if(!costs.worldToMap(x + dx * k / steps, y + dy * k / steps, mx, my))
+          return POT_HIGH;
+        // the robot's own cell is cleared for planning
+        if(mx == start_x && my == start_y)
+          continue;
+
+        // the traversal cost of Expander
+        float c = costs.getCost(mx, my);
+        if(c < lethal_cost_ - 1 || (allow_unknown_ && c == NS_CostMap::NO_INFORMATION))
+          c = std::min(c * cost_factor_ + neutral_cost_, lethal_cost_ - 1.0f);
+        else
+          return POT_HIGH;
+        cost += c * cells / steps;
+      }
+      x = plan[i].pose.position.x;
+      y = plan[i].pose.position.y;
+    }
+    return cost;
+  }
+
+  bool GlobalPlanner::runSearch(double start_x, double start_y, double end_x,
+                                double end_y)
+  {
+    search_cancelled_ = search_timed_out_ = false;
+    int nx = planning_costmap_.getSizeInCellsX(), ny = planning_costmap_.getSizeInCellsY();
+
+    planner_->setSlice(plan_slice_cells_, plan_slice_time_);
+    Expander::SearchState state = planner_->startSearch(
+        planning_costmap_.getCharMap(), start_x, start_y, end_x, end_y,
+        nx * ny * 2, potential_array_);
+    while(state == Expander::SEARCH_IN_PROGRESS)
+    {
+      if(preempted())
+      {
+        search_cancelled_ = true;
+        break;
+      }
+
+      // the last slice ends at the deadline
+      double slice_time = plan_slice_time_;
+      if(!deadline_.isZero())
+      {
+        double left = (deadline_ - NS_NaviCommon::Time::now()).toSec();
+        if(left <= 0)
+        {
+          search_timed_out_ = true;
+          break;
+        }
+        if(slice_time == 0 || left < slice_time)
+          slice_time = left;
+      }
+
+      planner_->setSlice(plan_slice_cells_, slice_time);
+      state = planner_->resumeSearch();
+    }
+    planner_->setSlice(0, 0);
+
+    if(search_cancelled_)
+      NS_NaviCommon::console.debug("Search given up for a newer plan");
+    return state == Expander::SEARCH_FOUND;
+  }
+
+  bool GlobalPlanner::preempted()
+  {
+    return plan_waiting_ || (improving_ && improveCancelled()) || (!preempt_check.empty() && preempt_check());
+  }
+
+  bool GlobalPlanner::improveCancelled()
+  {
+    boost::mutex::scoped_lock improved_lock(improved_lock_);
+    return goal_id_ != improve_goal_id_;
+  }
+
+  bool GlobalPlanner::getImprovedPlan(
+      std::vector< NS_DataType::PoseStamped >& plan)
+  {
+    boost::mutex::scoped_lock lock(improved_lock_);
+    if(!has_improved_)
+      return false;
+
+    plan.swap(improved_plan_);
+    improved_plan_.clear();
+    has_improved_ = false;
+    return true;
+  }
+
+  void GlobalPlanner::cancelImprovedPlans()
+  {
+    // mutex_ is held over whole rounds, the round running sees the new id
+    // between slices and gives up
+    boost::mutex::scoped_lock lock(improved_lock_);
+    improved_plan_.clear();
+    has_improved_ = false;
+    ++goal_id_;
+  }
+
+  bool GlobalPlanner::copyWindow(const NS_CostMap::Costmap2D& full,
+                                 const NS_DataType::PoseStamped& start,
+                                 const NS_DataType::PoseStamped& goal,
+                                 double margin_x, double margin_y)
+  {
+    int nx = full.getSizeInCellsX(), ny = full.getSizeInCellsY();
+    double resolution = full.getResolution();
+    int sx, sy, gx, gy;
+    full.worldToMapNoBounds(start.pose.position.x, start.pose.position.y, sx,
+                            sy);
+    full.worldToMapNoBounds(goal.pose.position.x, goal.pose.position.y, gx,
+                            gy);
+
+    // cells [x0, xn) x [y0, yn)
+    int mx = (int)ceil(margin_x / resolution), my = (int)ceil(margin_y / resolution);
+    int x0 = std::max(std::min(sx, gx) - mx, 0);
+    int y0 = std::max(std::min(sy, gy) - my, 0);
+    int xn = std::min(std::max(sx, gx) + mx + 1, nx);
+    int yn = std::min(std::max(sy, gy) + my + 1, ny);
+
+    if((x0 == 0 && y0 == 0 && xn == nx && yn == ny) || xn - x0 < 3 || yn - y0 < 3)
+    {
+      planning_costmap_ = full;
+      return false;
+    }
+
+    planning_costmap_.resizeMap(xn - x0, yn - y0, resolution,
+                                full.getOriginX() + x0 * resolution,
+                                full.getOriginY() + y0 * resolution);
+    const unsigned char* source = full.getCharMap();
+    unsigned char* window = planning_costmap_.getCharMap();
+    for(int y = y0; y < yn; y++)
+      memcpy(window + (y - y0) * (xn - x0), source + y * nx + x0, xn - x0);
+    return true;
+  }
+
+  bool GlobalPlanner::planOnCopy(unsigned long version,
+                                 const NS_DataType::PoseStamped& start,
+                                 const NS_DataType::PoseStamped& goal,
+                                 std::vector< NS_DataType::PoseStamped >& plan)
+  {
+    plan.clear();
 
     double wx = start.pose.position.x;
     double wy = start.pose.position.y;
@@ -202,9 +683,7 @@ namespace NS_Planner
      return &costmap_;
      }
      */
-    if(!costmap->getLayeredCostmap()->getCostmap()->worldToMap(wx, wy,
-                                                               start_x_i,
-                                                               start_y_i))
+    if(!planning_costmap_.worldToMap(wx, wy, start_x_i, start_y_i))
     {
       // 加一下错误提示
       printf(
@@ -225,8 +704,7 @@ namespace NS_Planner
 
 //	cout << "goal world wx = " << wx << " wy = " << wy << "\n";
 
-    if(!costmap->getLayeredCostmap()->getCostmap()->worldToMap(wx, wy, goal_x_i,
-                                                               goal_y_i))
+    if(!planning_costmap_.worldToMap(wx, wy, goal_x_i, goal_y_i))
     {
       // 加一下错误提示
       printf(
@@ -247,41 +725,92 @@ namespace NS_Planner
 //	tf::Stamped<tf::Pose> start_pose;
 //	tf::poseStampedMsgToTF(start, start_pose);
 //	clearRobotCell(start_pose, start_x_i, start_y_i);
-    clearRobotCell(start_x_i, start_y_i);
-
-//	NS_NaviCommon::console.debug("After clearRobotCell...");
 
     //int nx = costmap_->getSizeInCellsX(), ny = costmap_->getSizeInCellsY();
 
-    int nx = costmap->getLayeredCostmap()->getCostmap()->getSizeInCellsX(),
-        ny = costmap->getLayeredCostmap()->getCostmap()->getSizeInCellsY();
+    int nx = planning_costmap_.getSizeInCellsX(),
+        ny = planning_costmap_.getSizeInCellsY();
 
 //	NS_NaviCommon::console.debug("After getting nx, ny...");
 //	cout << "nx, ny = " << nx << " " << ny << "\n";
-    //make sure to resize the underlying array that Navfn uses
-    p_calc_->setSize(nx, ny); // PotentialCalculator* p_calc_;
-    planner_->setSize(nx, ny); // Expander* planner_;
-    path_maker_->setSize(nx, ny); // Traceback* path_maker_;
-    potential_array_ = new float[nx * ny]; // float* potential_array_;
+    fitWorkspace(nx, ny);
+    potential_array_ = workspace_.getPotential();
 
 //	NS_NaviCommon::console.debug("After parameters setSize...");
 
-    outlineMap(costmap->getLayeredCostmap()->getCostmap()->getCharMap(), nx, ny,
+    // a kept field serves the plans of any later robot cell, so it is
+    // calculated on the costs before clearRobotCell()
+    float* goal_field = NULL;
+    if(field_cache_ != NULL)
+    {
+      outlineMap(planning_costmap_.getCharMap(), nx, ny,
+                 NS_CostMap::LETHAL_OBSTACLE);
+      goal_field = getGoalField(version, goal_x_i, goal_y_i, start_x,
+                                start_y, goal_x, goal_y);
+    }
+
+    clearRobotCell(start_x_i, start_y_i);
+
+//	NS_NaviCommon::console.debug("After clearRobotCell...");
+
+    outlineMap(planning_costmap_.getCharMap(), nx, ny,
                NS_CostMap::LETHAL_OBSTACLE);
 
 //	NS_NaviCommon::console.debug("After outlineMap, invoking calculatePotentials...");
     /*
      * 此处开始调用算法
      */
-    bool found_legal = planner_->calculatePotentials(
-        costmap->getLayeredCostmap()->getCostmap()->getCharMap(), start_x,
-        start_y, goal_x, goal_y, nx * ny * 2, potential_array_);
+    bool found_legal;
+    int start_cell = start_y_i * nx + start_x_i;
+    float field_start_potential = POT_HIGH;
+
+    plan_from_goal_ = planner_->isIncremental() || goal_field != NULL;
+    plan_from_waypoints_ = theta_ != NULL && !plan_from_goal_;
+    if(goal_field != NULL)
+    {
+      // the field reaches every cell it can, only the traceback is left.
+      // The robot cell gets the potential of a cleared cell from its
+      // neighbors, and its own is put back once the plan is traced
+      potential_array_ = goal_field;
+      field_start_potential = goal_field[start_cell];
+      if(start_x_i != goal_x_i || start_y_i != goal_y_i)
+      {
+        goal_field[start_cell] = POT_HIGH;
+        dijkstra_->clearEndpoint(planning_costmap_.getCharMap(), goal_field,
+                                 start_x_i, start_y_i, 0);
+      }
+      found_legal = goal_field[start_cell] < POT_HIGH;
+    }
+    else if(planner_->isIncremental())
+    {
+      // repair the kept field rooted at the goal instead of a new search
+      markChanges(version, start_x_i, start_y_i);
+      found_legal = runSearch(goal_x, goal_y, start_x, start_y);
+    }
+    else
+    {
+      updateLandmarks();
+      found_legal = runSearch(start_x, start_y, goal_x, goal_y);
+    }
+
+    if(found_legal)
+      planned_cost_ = plan_from_goal_ ? potential_array_[start_cell] : potential_array_[goal_y_i * nx + goal_x_i];
+
+    if(goal_field == NULL)
+    {
+      ExpansionStats stats = planner_->getStats();
+      NS_NaviCommon::console.debug(
+          "Potentials: %lu cells visited, queue peak %lu, queue growths %lu",
+          stats.cells_visited, stats.max_queue, stats.queue_growths);
+    }
 
 //	NS_NaviCommon::console.debug("After calculatePotentials, invoking clearEndPoint...");
 
-    planner_->clearEndpoint(
-        costmap->getLayeredCostmap()->getCostmap()->getCharMap(),
-        potential_array_, goal_x_i, goal_y_i, 2);
+    // the goal of an incremental or cached field is its root already, and
+    // the field must stay as it is
+    if(!plan_from_goal_)
+      planner_->clearEndpoint(planning_costmap_.getCharMap(), potential_array_,
+                              goal_x_i, goal_y_i, 2);
 
 //	NS_NaviCommon::console.debug("After clearEndpoint...");
 
@@ -311,13 +840,239 @@ namespace NS_Planner
       printf("Failed to get a plan.\n");
     }
 
+    if(goal_field != NULL)
+      goal_field[start_cell] = field_start_potential;
+
     // add orientations if needed
     orientation_filter_->processPath(start, plan);
 
-    delete potential_array_;
     return !plan.empty(); // plan 非空即制订了 plan，返回 true
   }
 
+  void GlobalPlanner::markChanges(unsigned long version, unsigned int robot_x,
+                                  unsigned int robot_y)
+  {
+    unsigned char* costs = planning_costmap_.getCharMap();
+    std::vector< NS_CostMap::DirtyRect > changes;
+
+    if(planned_version_ == 0 || !costmap->getLayeredCostmap()->getChangesSince(
+        planned_version_, changes))
+    {
+      planner_->resetSearch();
+    }
+    else
+    {
+      for(unsigned int i = 0; i < changes.size(); i++)
+      {
+        int x0, y0, xn, yn;
+        planning_costmap_.worldToMapEnforceBounds(changes[i].min_x,
+                                                  changes[i].min_y, x0, y0);
+        planning_costmap_.worldToMapEnforceBounds(changes[i].max_x,
+                                                  changes[i].max_y, xn, yn);
+        planner_->markChanged(costs, x0, y0, xn + 1, yn + 1);
+      }
+
+      // clearRobotCell() changed the previous and the current robot cell
+      planner_->markChanged(costs, planned_robot_x_, planned_robot_y_,
+                            planned_robot_x_ + 1, planned_robot_y_ + 1);
+      planner_->markChanged(costs, robot_x, robot_y, robot_x + 1, robot_y + 1);
+    }
+
+    planned_version_ = version;
+    planned_robot_x_ = robot_x;
+    planned_robot_y_ = robot_y;
+  }
+
+  bool GlobalPlanner::getCostsToGo(
+      const NS_DataType::PoseStamped& start,
+      const std::vector< NS_DataType::PoseStamped >& targets, bool make_paths,
+      std::vector< CostToGo >& results)
+  {
+    // the query goes before improving the last plan, like a new plan
+    plan_waiting_ = true;
+    boost::mutex::scoped_lock lock(mutex_);
+    plan_waiting_ = false;
+
+    results.assign(targets.size(), CostToGo());
+    if(!initialized_)
+    {
+      printf(
+          "This planner has not been initialized yet, but it is being used, please call initialize() before use\n");
+      return false;
+    }
+
+    NS_CostMap::CostmapSnapshotPtr snapshot = costmap->getSnapshot();
+    if(snapshot->getVersion() == 0)
+    {
+      printf("The costmap has not been published yet, unable to plan.\n");
+      return false;
+    }
+    planning_costmap_ = snapshot->getCostmap();
+
+    unsigned int start_x_i, start_y_i;
+    double start_x, start_y;
+    if(!planning_costmap_.worldToMap(start.pose.position.x,
+                                     start.pose.position.y, start_x_i,
+                                     start_y_i) || !worldToMap(start.pose.position.x, start.pose.position.y, start_x, start_y))
+    {
+      printf(
+          "The robot's start position is off the global costmap. Planning will always fail, are you sure the robot has been properly localized?\n");
+      return false;
+    }
+    clearRobotCell(start_x_i, start_y_i);
+
+    int nx = planning_costmap_.getSizeInCellsX(),
+        ny = planning_costmap_.getSizeInCellsY();
+    fitWorkspace(nx, ny);
+    outlineMap(planning_costmap_.getCharMap(), nx, ny,
+               NS_CostMap::LETHAL_OBSTACLE);
+
+    // targets off the map stay unreachable
+    std::vector< int > cells(targets.size(), -1);
+    std::vector< int > wanted;
+    for(unsigned int i = 0; i < targets.size(); i++)
+    {
+      unsigned int x, y;
+      if(!planning_costmap_.worldToMap(targets[i].pose.position.x,
+                                       targets[i].pose.position.y, x, y))
+        continue;
+      cells[i] = y * nx + x;
+      wanted.push_back(cells[i]);
+    }
+
+    // a buffer of its own keeps the fields of the planner intact
+    wave_potential_.resize(nx * ny);
+    potential_array_ = &wave_potential_[0];
+    wave_->calculatePotentials(planning_costmap_.getCharMap(), start_x,
+                               start_y, wanted, nx * ny * 2, potential_array_);
+
+    ExpansionStats stats = wave_->getStats();
+    NS_NaviCommon::console.debug(
+        "Costs to go: %u targets, %lu cells visited, queue peak %lu",
+        (unsigned int)targets.size(), stats.cells_visited, stats.max_queue);
+
+    // the paths follow the gradient of the wave, whatever planner_ is
+    plan_from_goal_ = false;
+    plan_from_waypoints_ = false;
+    for(unsigned int i = 0; i < targets.size(); i++)
+    {
+      if(cells[i] < 0)
+        continue;
+
+      // a target in an obstacle takes its cost from its neighbors, as
+      // clearEndpoint() lets makePlan() reach it, away from the map edge
+      int x = cells[i] % nx, y = cells[i] / nx;
+      if(x >= 2 && y >= 2 && x < nx - 2 && y < ny - 2)
+        wave_->clearEndpoint(planning_costmap_.getCharMap(), potential_array_,
+                             x, y, 1);
+      float cost = potential_array_[cells[i]];
+      if(cost >= POT_HIGH)
+        continue;
+      results[i].reachable = true;
+      results[i].cost = cost;
+
+      if(!make_paths)
+        continue;
+      double goal_x, goal_y;
+      worldToMap(targets[i].pose.position.x, targets[i].pose.position.y,
+                 goal_x, goal_y);
+      std::vector< NS_DataType::PoseStamped >& path = results[i].path;
+      if(getPlanFromPotential(start_x, start_y, goal_x, goal_y, targets[i],
+                              path))
+      {
+        NS_DataType::PoseStamped goal_copy = targets[i];
+        goal_copy.header.stamp = NS_NaviCommon::Time::now();
+        path.push_back(goal_copy);
+      }
+      orientation_filter_->processPath(start, path);
+    }
+    return true;
+  }
+
+  void GlobalPlanner::fitWorkspace(int nx, int ny)
+  {
+    //make sure to resize the underlying array that Navfn uses, the
+    //workspace only reallocates when the map size changed
+    if(workspace_.setSize(nx, ny))
+    {
+      p_calc_->setSize(nx, ny); // PotentialCalculator* p_calc_;
+      planner_->setSize(nx, ny); // Expander* planner_;
+      path_maker_->setSize(nx, ny); // Traceback* path_maker_;
+      if(wave_ != planner_)
+        wave_->setSize(nx, ny);
+    }
+  }
+
+  float* GlobalPlanner::getGoalField(unsigned long version,
+                                     unsigned int goal_x_i,
+                                     unsigned int goal_y_i, double start_x,
+                                     double start_y, double goal_x,
+                                     double goal_y)
+  {
+    unsigned char* costs = planning_costmap_.getCharMap();
+    int nx = planning_costmap_.getSizeInCellsX(),
+        ny = planning_costmap_.getSizeInCellsY();
+    std::vector< NS_CostMap::DirtyRect > changes;
+
+    // drop the fields whose costs changed since they were last checked
+    if(field_cache_->getSizeX() != nx || field_cache_->getSizeY() != ny || field_cache_version_ == 0 || !costmap->getLayeredCostmap()->getChangesSince(field_cache_version_, changes))
+    {
+      field_cache_->clear(nx, ny);
+    }
+    else
+    {
+      for(unsigned int i = 0; i < changes.size(); i++)
+      {
+        int x0, y0, xn, yn;
+        planning_costmap_.worldToMapEnforceBounds(changes[i].min_x,
+                                                  changes[i].min_y, x0, y0);
+        planning_costmap_.worldToMapEnforceBounds(changes[i].max_x,
+                                                  changes[i].max_y, xn, yn);
+        field_cache_->markChanged(costs, x0, y0, xn + 1, yn + 1);
+      }
+    }
+    field_cache_version_ = version;
+
+    int goal = goal_y_i * nx + goal_x_i;
+    float* field = field_cache_->find(goal);
+    if(field != NULL)
+    {
+      NS_NaviCommon::console.debug(
+          "Potentials: reused the field of goal %d, %d, %u fields cached",
+          goal_x_i, goal_y_i, field_cache_->size());
+      return field;
+    }
+
+    field = field_cache_->insert(goal, costs);
+    if(field == NULL)
+      return NULL;
+
+    dijkstra_->setExpandAll(true);
+    dijkstra_->calculatePotentials(costs, goal_x, goal_y, start_x, start_y,
+                                   nx * ny * 2, field);
+    dijkstra_->setExpandAll(false);
+    field_cache_->setReached(goal);
+
+    ExpansionStats stats = planner_->getStats();
+    NS_NaviCommon::console.debug(
+        "Potentials: new field of goal %d, %d, %lu cells visited, %u fields cached",
+        goal_x_i, goal_y_i, stats.cells_visited, field_cache_->size());
+    return field;
+  }
+
+  void GlobalPlanner::updateLandmarks()
+  {
+    if(landmarks_ == NULL || !landmarks_->needsBuild(static_layer_->getMapVersion()))
+      return;
+
+    std::vector< unsigned char > costs;
+    unsigned int size_x, size_y;
+    unsigned long version = static_layer_->copyMap(costs, size_x, size_y);
+    // the map may have changed again since its version was read
+    if(landmarks_->needsBuild(version))
+      landmarks_->build(costs, size_x, size_y, version);
+  }
+
   void GlobalPlanner::clearRobotCell(unsigned int mx, unsigned int my)
   {
     if(!initialized_)
@@ -329,8 +1084,7 @@ namespace NS_Planner
     }
 
     //set the associated costs in the cost map to be free
-    costmap->getLayeredCostmap()->getCostmap()->setCost(mx, my,
-                                                        NS_CostMap::FREE_SPACE);
+    planning_costmap_.setCost(mx, my, NS_CostMap::FREE_SPACE);
   }
 
   bool GlobalPlanner::getPlanFromPotential(
@@ -353,13 +1107,28 @@ namespace NS_Planner
 
     std::vector< std::pair< float, float > > path;
 
-    if(!path_maker_->getPath(potential_array_, start_x, start_y, goal_x, goal_y,
-                             path))
+    // the traceback runs down the potential, from the robot when the
+    // potential is the cost to the goal
+    bool from_goal = plan_from_goal_;
+    bool found;
+    if(plan_from_waypoints_)
+      found = theta_->getWaypoints(
+          waypoint_spacing_ / planning_costmap_.getResolution(), path);
+    else if(from_goal)
+      found = path_maker_->getPath(potential_array_, goal_x, goal_y, start_x,
+                                   start_y, path);
+    else
+      found = path_maker_->getPath(potential_array_, start_x, start_y, goal_x,
+                                   goal_y, path);
+    if(!found)
     {
       // 错误提示
       printf("NO PATH!\n");
       return false;
     }
+    // the plan is built from the back of path, which has to be the robot
+    if(from_goal)
+      std::reverse(path.begin(), path.end());
 
     NS_NaviCommon::Time plan_time = NS_NaviCommon::Time::now();
     for(int i = path.size() - 1; i >= 0; i--)
@@ -388,15 +1157,15 @@ namespace NS_Planner
 
   void GlobalPlanner::mapToWorld(double mx, double my, double& wx, double& wy)
   {
-    wx = costmap->getLayeredCostmap()->getCostmap()->getOriginX() + (mx + convert_offset_) * costmap->getLayeredCostmap()->getCostmap()->getResolution();
-    wy = costmap->getLayeredCostmap()->getCostmap()->getOriginY() + (my + convert_offset_) * costmap->getLayeredCostmap()->getCostmap()->getResolution();
+    wx = planning_costmap_.getOriginX() + (mx + convert_offset_) * planning_costmap_.getResolution();
+    wy = planning_costmap_.getOriginY() + (my + convert_offset_) * planning_costmap_.getResolution();
   }
 
   bool GlobalPlanner::worldToMap(double wx, double wy, double& mx, double& my)
   {
-    double origin_x = costmap->getLayeredCostmap()->getCostmap()->getOriginX(),
-        origin_y = costmap->getLayeredCostmap()->getCostmap()->getOriginY();
-    double resolution = costmap->getLayeredCostmap()->getCostmap()->getResolution();
+    double origin_x = planning_costmap_.getOriginX(),
+        origin_y = planning_costmap_.getOriginY();
+    double resolution = planning_costmap_.getResolution();
 
     if(wx < origin_x || wy < origin_y)
       return false;
@@ -404,7 +1173,7 @@ namespace NS_Planner
     mx = (wx - origin_x) / resolution - convert_offset_;
     my = (wy - origin_y) / resolution - convert_offset_;
 
-    if(mx < costmap->getLayeredCostmap()->getCostmap()->getSizeInCellsX() && my < costmap->getLayeredCostmap()->getCostmap()->getSizeInCellsY())
+    if(mx < planning_costmap_.getSizeInCellsX() && my < planning_costmap_.getSizeInCellsY())
       return true;
 
     return false;
@@ -7,12 +7,26 @@
 #include "Algorithm/Expander.h"
 #include "Algorithm/Traceback.h"
 #include "Algorithm/OrientationFilter.h"
+#include "Algorithm/PlannerWorkspace.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition.hpp>
+
+namespace NS_CostMap
+{
+  class StaticLayer;
+}
 
 namespace NS_Planner
 {
 
   class Expander;
   class GridPath;
+  class LandmarkHeuristic;
+  class DijkstraExpansion;
+  class AStarExpansion;
+  class ThetaStarExpansion;
+  class FieldCache;
 
   class GlobalPlanner: public GlobalPlannerBase
   {
@@ -31,6 +45,17 @@ namespace NS_Planner
 
 //	bool makePlanService(NS_ServiceType::RequestBase*  req, NS_ServiceType::ResponseBase* resp);
 
+    bool
+    getCostsToGo(const NS_DataType::PoseStamped& start,
+                 const std::vector< NS_DataType::PoseStamped >& targets,
+                 bool make_paths, std::vector< CostToGo >& results);
+
+    bool
+    getImprovedPlan(std::vector< NS_DataType::PoseStamped >& plan);
+
+    void
+    cancelImprovedPlans();
+
     bool
     getPlanFromPotential(double start_x, double start_y, double end_x,
                          double end_y, const NS_DataType::PoseStamped& goal,
@@ -51,9 +76,89 @@ namespace NS_Planner
     worldToMap(double wx, double wy, double& mx, double& my);
     void
     clearRobotCell(unsigned int mx, unsigned int my);
+    /**
+     * @brief Plan from start to goal on the latest costmap snapshot, call with mutex_ held
+     */
+    bool
+    planOnSnapshot(const NS_DataType::PoseStamped& start,
+                   const NS_DataType::PoseStamped& goal,
+                   std::vector< NS_DataType::PoseStamped >& plan);
+    /**
+     * @brief Search planner_ in slices, giving up between two if preempted() or past deadline_
+     * @return False if no path was found, search_cancelled_ and search_timed_out_ tell if it was given up
+     */
+    bool
+    runSearch(double start_x, double start_y, double end_x, double end_y);
+    /**
+     * @brief True if the running search is to be given up for a newer plan
+     */
+    bool
+    preempted();
+    /**
+     * @brief True if the goal of the improvement rounds was replaced or cancelled since makePlan() set it
+     */
+    bool
+    improveCancelled();
+    /**
+     * @brief Background loop of anytime mode, plans to the last goal again with a lower A* weight each round
+     */
+    void
+    improvePlans();
+    /**
+     * @brief Traversal cost of plan on costs, from start on to the plan pose nearest to it and along the plan from there
+     * @return POT_HIGH if the plan is empty or crosses a cell that can not be entered
+     */
+    float
+    planCost(const NS_CostMap::Costmap2D& costs,
+             const NS_DataType::PoseStamped& start,
+             const std::vector< NS_DataType::PoseStamped >& plan);
+    /**
+     * @brief Copy the cells around start and goal, with a margin in meters, to planning_costmap_
+     * @return False if the window takes the whole map, which is copied then
+     */
+    bool
+    copyWindow(const NS_CostMap::Costmap2D& full,
+               const NS_DataType::PoseStamped& start,
+               const NS_DataType::PoseStamped& goal, double margin_x,
+               double margin_y);
+    /**
+     * @brief Plan from start to goal on planning_costmap_, a copy of the snapshot of version
+     */
+    bool
+    planOnCopy(unsigned long version, const NS_DataType::PoseStamped& start,
+               const NS_DataType::PoseStamped& goal,
+               std::vector< NS_DataType::PoseStamped >& plan);
+    /**
+     * @brief Tell an incremental expander which cells changed since the last plan
+     * @param version Version of the snapshot planned on now
+     */
+    void
+    markChanges(unsigned long version, unsigned int robot_x,
+                unsigned int robot_y);
+    /**
+     * @brief Resize the workspace and everything that works on it, if the map size changed
+     */
+    void
+    fitWorkspace(int nx, int ny);
+    /**
+     * @brief The cached potential field rooted at the goal, calculated first if there is none
+     *
+     * Fields are calculated on the costs before the robot cell is cleared,
+     * so a robot that moved does not drop them.
+     * @return NULL if a field does not fit in the cache
+     */
+    float*
+    getGoalField(unsigned long version, unsigned int goal_x_i,
+                 unsigned int goal_y_i, double start_x, double start_y,
+                 double goal_x, double goal_y);
+    /**
+     * @brief Start rebuilding the landmark tables if the static map changed
+     */
+    void
+    updateLandmarks();
 //     void publishPotential(float* potential);
 
-    double planner_window_x_, planner_window_y_, default_tolerance_;
+    double planner_window_x_, planner_window_y_, default_tolerance_; ///< planner_window_x_/y_ are the margins in meters of the searched window around start and goal, 0 searches the whole map
 //     std::string tf_prefix_;
     boost::mutex mutex_;
 //     ros::ServiceServer make_plan_srv_;
@@ -70,8 +175,52 @@ namespace NS_Planner
     void
     outlineMap(unsigned char* costarr, int nx, int ny, unsigned char value);
     unsigned char* cost_array_;
-    float* potential_array_;
+    PlannerWorkspace workspace_; ///< Per-cell arrays of the expander and the traceback, kept between plans
+    float* potential_array_; ///< Borrowed from workspace_
+    NS_CostMap::Costmap2D planning_costmap_; ///< Private copy of the costmap snapshot, the planner clears the start cell and outlines it
     unsigned int start_x_, start_y_, end_x_, end_y_;
+    unsigned long planned_version_; ///< Snapshot version of the last plan, 0 before the first
+    unsigned int planned_robot_x_, planned_robot_y_; ///< Robot cell of the last plan, cleared in its costmap copy
+    LandmarkHeuristic* landmarks_; ///< Landmark tables for A*, NULL unless use_landmarks
+    NS_CostMap::StaticLayer* static_layer_; ///< Static layer of the global costmap the landmarks are built on
+    DijkstraExpansion* dijkstra_; ///< planner_ if it is Dijkstra, NULL otherwise
+    FieldCache* field_cache_; ///< Fields rooted at recent goals, NULL unless field_cache_mb is set
+    unsigned long field_cache_version_; ///< Snapshot version field_cache_ was last checked against
+    bool plan_from_goal_; ///< The potential of this plan is rooted at the goal
+    bool plan_from_waypoints_; ///< This plan is taken from the waypoints of theta_, set by planOnCopy() only
+    DijkstraExpansion* wave_; ///< Search of batch queries, dijkstra_ if there is one
+    std::vector< float > wave_potential_; ///< Potential of the last batch query
+    float planned_cost_; ///< Potential between start and goal of the last search, POT_HIGH if none was found
+    unsigned char lethal_cost_, neutral_cost_; ///< Cost model of planner_, for planCost()
+    float cost_factor_;
+    ThetaStarExpansion* theta_; ///< planner_ if it is Theta*, its plans are taken from its waypoints instead of path_maker_
+    double waypoint_spacing_; ///< Meters between the points of a Theta* plan at most, 0 keeps only its turns
+
+    // searches in slices, to be given up in between
+    unsigned long plan_slice_cells_; ///< Cells expanded per slice, 0 for no bound
+    double plan_slice_time_; ///< Seconds per slice, 0 for no bound
+    NS_NaviCommon::Time deadline_; ///< Searches give up after it, a zero time never does
+    bool search_cancelled_; ///< The last search was given up for a newer plan
+    bool search_timed_out_; ///< The last search was given up on deadline_
+
+    // anytime mode, A* with a weight lowered over rounds
+    AStarExpansion* astar_; ///< planner_ if it is A*, NULL otherwise
+    double anytime_time_limit_; ///< Seconds makePlan() searches for, anytime mode is off at 0
+    float anytime_weight_, anytime_weight_step_; ///< A* weight of the first round, and how much each next round lowers it
+    boost::thread improve_thread_;
+    boost::condition improve_cond_;
+    volatile bool plan_waiting_; ///< A makePlan() call waits for mutex_, the running round gives up
+    volatile bool stop_improving_;
+    bool improve_pending_; ///< Guarded by mutex_, like the rest of the round state
+    bool improving_; ///< A round is running
+    NS_DataType::PoseStamped improve_goal_;
+    unsigned long improve_goal_id_; ///< goal_id_ when makePlan() set improve_goal_
+    float improve_weight_; ///< A* weight of the next round
+    std::vector< NS_DataType::PoseStamped > improve_plan_; ///< The best plan to improve_goal_ handed out, empty if none
+    boost::mutex improved_lock_; ///< Guards improved_plan_, has_improved_ and goal_id_, mutex_ is held over whole rounds
+    std::vector< NS_DataType::PoseStamped > improved_plan_;
+    bool has_improved_;
+    unsigned long goal_id_; ///< Counts the goals of makePlan() and the cancellations of their improvement
 
 //     bool old_navfn_behavior_; // 默认为 false
     float convert_offset_;
@@ -0,0 +1,468 @@
+#include "ClusterGraph.h"
+#include "../GlobalPlanner/Algorithm/Expander.h"
+#include <algorithm>
+
+namespace NS_Planner
+{
+
+  ClusterGraph::ClusterGraph()
+      : nx_(0), ny_(0), cluster_size_(1), cnx_(0), cny_(0), lethal_cost_(253),
+        neutral_cost_(50), factor_(3.0), unknown_(true), node_generation_(0),
+        targets_left_(0), cell_generation_(0)
+  {
+  }
+
+  void ClusterGraph::setCosts(unsigned char lethal_cost,
+                              unsigned char neutral_cost, float factor,
+                              bool unknown)
+  {
+    lethal_cost_ = lethal_cost;
+    neutral_cost_ = neutral_cost;
+    factor_ = factor;
+    unknown_ = unknown;
+    markAllChanged();
+  }
+
+  void ClusterGraph::setSize(int nx, int ny, int cluster_size)
+  {
+    nx_ = nx;
+    ny_ = ny;
+    cluster_size_ = std::max(cluster_size, 2);
+    cnx_ = (nx + cluster_size_ - 1) / cluster_size_;
+    cny_ = (ny + cluster_size_ - 1) / cluster_size_;
+
+    clusters_.assign(cnx_ * cny_, Cluster());
+    for(int cy = 0; cy < cny_; cy++)
+    {
+      for(int cx = 0; cx < cnx_; cx++)
+      {
+        Cluster& cluster = clusters_[cy * cnx_ + cx];
+        cluster.x0 = cx * cluster_size_;
+        cluster.y0 = cy * cluster_size_;
+        cluster.xn = std::min(cluster.x0 + cluster_size_, nx_);
+        cluster.yn = std::min(cluster.y0 + cluster_size_, ny_);
+      }
+    }
+
+    region_.clear();
+    region_slot_.assign(clusters_.size(), -1);
+    node_offset_.assign(clusters_.size(), 0);
+    node_cluster_.clear();
+
+    changed_clusters_.clear();
+    for(unsigned int k = 0; k < clusters_.size(); k++)
+      changed_clusters_.push_back(k);
+  }
+
+  void ClusterGraph::markChanged(int x0, int y0, int xn, int yn)
+  {
+    // the entrances on a border depend on the cells at both sides of it
+    x0 = std::max(x0 - 1, 0);
+    y0 = std::max(y0 - 1, 0);
+    xn = std::min(xn + 1, nx_);
+    yn = std::min(yn + 1, ny_);
+    if(x0 >= xn || y0 >= yn)
+      return;
+
+    for(int cy = y0 / cluster_size_; cy <= (yn - 1) / cluster_size_; cy++)
+    {
+      for(int cx = x0 / cluster_size_; cx <= (xn - 1) / cluster_size_; cx++)
+      {
+        int k = cy * cnx_ + cx;
+        if(clusters_[k].changed)
+          continue;
+        clusters_[k].changed = true;
+        changed_clusters_.push_back(k);
+      }
+    }
+  }
+
+  void ClusterGraph::markAllChanged()
+  {
+    markChanged(0, 0, nx_, ny_);
+  }
+
+  void ClusterGraph::update(unsigned char* costs)
+  {
+    stats_.clusters_rebuilt = changed_clusters_.size();
+    if(changed_clusters_.empty())
+      return;
+
+    // the paths between the new nodes are left to the searches that need them
+    for(unsigned int i = 0; i < changed_clusters_.size(); i++)
+    {
+      Cluster& cluster = clusters_[changed_clusters_[i]];
+      buildEntrances(costs, changed_clusters_[i]);
+      cluster.changed = false;
+      cluster.paths_built = false;
+    }
+    changed_clusters_.clear();
+
+    node_cluster_.clear();
+    for(unsigned int k = 0; k < clusters_.size(); k++)
+    {
+      node_offset_[k] = node_cluster_.size();
+      node_cluster_.insert(node_cluster_.end(), clusters_[k].nodes.size(), k);
+    }
+    stats_.entrance_nodes = node_cluster_.size();
+  }
+
+  void ClusterGraph::buildEntrances(unsigned char* costs, int k)
+  {
+    Cluster& cluster = clusters_[k];
+    cluster.nodes.clear();
+    cluster.partners.clear();
+
+    int width = cluster.xn - cluster.x0, height = cluster.yn - cluster.y0;
+    int first = cluster.y0 * nx_ + cluster.x0;
+    int last_row = (cluster.yn - 1) * nx_ + cluster.x0;
+
+    // both clusters of a border find the same entrances on it, scanning
+    // their own side in the same direction
+    if(cluster.x0 > 0)
+      addEntrances(costs, cluster, first, nx_, -1, height);
+    if(cluster.xn < nx_)
+      addEntrances(costs, cluster, first + width - 1, nx_, 1, height);
+    if(cluster.y0 > 0)
+      addEntrances(costs, cluster, first, 1, -nx_, width);
+    if(cluster.yn < ny_)
+      addEntrances(costs, cluster, last_row, 1, nx_, width);
+  }
+
+  void ClusterGraph::addEntrances(unsigned char* costs, Cluster& cluster,
+                                  int first, int step, int across, int length)
+  {
+    int run = 0;
+    for(int i = 0; i <= length; i++)
+    {
+      int n = first + i * step;
+      if(i < length && isPassable(costs, n) && isPassable(costs, n + across))
+      {
+        run++;
+        continue;
+      }
+      if(run == 0)
+        continue;
+
+      // one node in the middle, the refining search does not have to pass
+      // through it, so a wide entrance needs no more
+      int middle = n - run * step + (run - 1) / 2 * step;
+      addNode(cluster, middle, middle + across);
+      run = 0;
+    }
+  }
+
+  void ClusterGraph::addNode(Cluster& cluster, int cell, int partner)
+  {
+    // a corner cell can be a node for two borders
+    int i = findNode(cluster, cell);
+    if(i < 0)
+    {
+      i = cluster.nodes.size();
+      cluster.nodes.push_back(cell);
+      cluster.partners.push_back(std::vector< int >());
+    }
+    cluster.partners[i].push_back(partner);
+  }
+
+  void ClusterGraph::buildPaths(unsigned char* costs, int k)
+  {
+    Cluster& cluster = clusters_[k];
+    int count = cluster.nodes.size();
+    cluster.paths.assign(count * count, POT_HIGH);
+    cluster.paths_built = true;
+
+    clearRegion();
+    addToRegion(costs, k);
+
+    // paths are the same both ways, the last node needs no search of its
+    // own and a search can stop once the nodes after its own are reached
+    for(int i = 0; i < count; i++)
+    {
+      cluster.paths[i * count + i] = 0;
+      if(i + 1 == count)
+        break;
+
+      for(int j = i + 1; j < count; j++)
+        cell_target_[localIndex(cluster.nodes[j] % nx_, cluster.nodes[j] / nx_)] = 1;
+      targets_left_ = count - i - 1;
+
+      searchCells(costs, cluster.nodes[i], -1);
+
+      for(int j = i + 1; j < count; j++)
+      {
+        float cost = reachedCost(cluster.nodes[j]);
+        cluster.paths[i * count + j] = cost;
+        cluster.paths[j * count + i] = cost;
+        cell_target_[localIndex(cluster.nodes[j] % nx_, cluster.nodes[j] / nx_)] = 0;
+      }
+      targets_left_ = 0;
+    }
+  }
+
+  void ClusterGraph::clearRegion()
+  {
+    for(unsigned int i = 0; i < region_.size(); i++)
+      region_slot_[region_[i]] = -1;
+    region_.clear();
+  }
+
+  void ClusterGraph::addToRegion(unsigned char* costs, int k)
+  {
+    if(region_slot_[k] >= 0)
+      return;
+    region_slot_[k] = region_.size();
+    region_.push_back(k);
+
+    unsigned int area = cluster_size_ * cluster_size_;
+    unsigned int size = region_.size() * area;
+    if(cell_marks_.size() < size)
+    {
+      cell_terrain_.resize(size);
+      cell_target_.resize(size, 0);
+      cell_cost_.resize(size);
+      cell_parent_.resize(size);
+      cell_positions_.resize(size);
+      cell_marks_.resize(size, 0);
+    }
+
+    const Cluster& cluster = clusters_[k];
+    float* terrain = &cell_terrain_[region_slot_[k] * area];
+    std::fill(terrain, terrain + area, (float)lethal_cost_);
+    for(int y = cluster.y0; y < cluster.yn; y++)
+    {
+      for(int x = cluster.x0; x < cluster.xn; x++)
+        terrain[(y - cluster.y0) * cluster_size_ + x - cluster.x0] = getCost(
+            costs, y * nx_ + x);
+    }
+  }
+
+  unsigned long ClusterGraph::searchCells(unsigned char* costs, int source,
+                                          int target)
+  {
+    if(++cell_generation_ == 0)
+    {
+      std::fill(cell_marks_.begin(), cell_marks_.end(), 0);
+      cell_generation_ = 1;
+    }
+    cell_queue_.reset(&cell_positions_[0]);
+
+    int s = localIndex(source % nx_, source / nx_);
+    cell_marks_[s] = cell_generation_;
+    cell_cost_[s] = 0;
+    cell_parent_[s] = -1;
+    cell_queue_.push(s, target < 0 ? 0 : distance(source, target));
+
+    int area = cluster_size_ * cluster_size_;
+    int targets_left = targets_left_;
+    unsigned long expanded = 0;
+    while(!cell_queue_.empty())
+    {
+      int l = cell_queue_.pop();
+      int n = cellOf(l);
+      expanded++;
+      if(n == target || (targets_left > 0 && cell_target_[l] && --targets_left == 0))
+        break;
+
+      const Cluster& cluster = clusters_[region_[l / area]];
+      int column = l % cluster_size_, row = (l % area) / cluster_size_;
+      bool inner = column > 0 && row > 0 && column + 1 < cluster.xn - cluster.x0
+          && row + 1 < cluster.yn - cluster.y0;
+
+      for(int dy = -1; dy <= 1; dy++)
+      {
+        for(int dx = -1; dx <= 1; dx++)
+        {
+          if(dx == 0 && dy == 0)
+            continue;
+          bool diagonal = dx != 0 && dy != 0;
+          int m = n + dy * nx_ + dx;
+
+          if(inner)
+          {
+            // all neighbors are in the cluster of n, use the region costs
+            int ml = l + dy * cluster_size_ + dx;
+            if(cell_terrain_[ml] >= lethal_cost_)
+              continue;
+            // no cutting corners of obstacles
+            if(diagonal && (cell_terrain_[l + dx] >= lethal_cost_ || cell_terrain_[l + dy * cluster_size_] >= lethal_cost_))
+              continue;
+
+            float cost = cell_cost_[l] + (cell_terrain_[l] + cell_terrain_[ml]) * (diagonal ? 0.5 * M_SQRT2 : 0.5);
+            reachCell(ml, l, cost, cost + (target < 0 ? 0 : distance(m, target)));
+            continue;
+          }
+
+          int mx = n % nx_ + dx, my = n / nx_ + dy;
+          if(mx < 0 || my < 0 || mx >= nx_ || my >= ny_)
+            continue;
+          int ml = localIndex(mx, my);
+          if(ml < 0 || !isPassable(costs, m))
+            continue;
+          if(diagonal && (!isPassable(costs, n + dx) || !isPassable(costs,
+                                                                   n + dy * nx_)))
+            continue;
+
+          float cost = cell_cost_[l] + stepCost(costs, n, m, diagonal);
+          reachCell(ml, l, cost, cost + (target < 0 ? 0 : distance(m, target)));
+        }
+      }
+    }
+    return expanded;
+  }
+
+  float ClusterGraph::reachedCost(int n)
+  {
+    int l = localIndex(n % nx_, n / nx_);
+    if(l < 0 || cell_marks_[l] != cell_generation_)
+      return POT_HIGH;
+    return cell_cost_[l];
+  }
+
+  void ClusterGraph::reachNode(int id, int cell, int goal, float cost,
+                               int parent)
+  {
+    float key = cost + distance(cell, goal);
+    if(node_marks_[id] != node_generation_)
+    {
+      node_marks_[id] = node_generation_;
+      node_cost_[id] = cost;
+      node_parent_[id] = parent;
+      node_queue_.push(id, key);
+    }
+    else if(node_positions_[id] >= 0 && cost < node_cost_[id])
+    {
+      node_cost_[id] = cost;
+      node_parent_[id] = parent;
+      node_queue_.decrease(id, key);
+    }
+  }
+
+  bool ClusterGraph::findPath(unsigned char* costs, int start, int goal,
+                              std::vector< int >& path)
+  {
+    stats_.paths_built = stats_.abstract_expanded = stats_.connect_expanded = 0;
+    stats_.refined_expanded = stats_.refined_clusters = 0;
+    path.clear();
+
+    if(!isPassable(costs, goal))
+      return false;
+
+    int ks = clusterOf(start % nx_, start / nx_);
+    int kg = clusterOf(goal % nx_, goal / nx_);
+    const Cluster& start_cluster = clusters_[ks];
+    const Cluster& goal_cluster = clusters_[kg];
+
+    // link the start and the goal to the nodes of their clusters
+    clearRegion();
+    addToRegion(costs, ks);
+    stats_.connect_expanded += searchCells(costs, start, -1);
+    std::vector< float > start_links(start_cluster.nodes.size());
+    for(unsigned int i = 0; i < start_links.size(); i++)
+      start_links[i] = reachedCost(start_cluster.nodes[i]);
+    float direct = ks == kg ? reachedCost(goal) : POT_HIGH;
+
+    clearRegion();
+    addToRegion(costs, kg);
+    stats_.connect_expanded += searchCells(costs, goal, -1);
+    std::vector< float > goal_links(goal_cluster.nodes.size());
+    for(unsigned int i = 0; i < goal_links.size(); i++)
+      goal_links[i] = reachedCost(goal_cluster.nodes[i]);
+
+    // search the abstract graph, the start and the goal come after the nodes
+    int start_id = node_cluster_.size(), goal_id = start_id + 1;
+    if(node_marks_.size() < (unsigned int)goal_id + 1)
+    {
+      node_cost_.resize(goal_id + 1);
+      node_parent_.resize(goal_id + 1);
+      node_positions_.resize(goal_id + 1);
+      node_marks_.resize(goal_id + 1, 0);
+    }
+    if(++node_generation_ == 0)
+    {
+      std::fill(node_marks_.begin(), node_marks_.end(), 0);
+      node_generation_ = 1;
+    }
+    node_queue_.reset(&node_positions_[0]);
+
+    reachNode(start_id, start, goal, 0, -1);
+    bool found = false;
+    while(!node_queue_.empty())
+    {
+      int id = node_queue_.pop();
+      stats_.abstract_expanded++;
+      if(id == goal_id)
+      {
+        found = true;
+        break;
+      }
+
+      float cost = node_cost_[id];
+      if(id == start_id)
+      {
+        for(unsigned int i = 0; i < start_links.size(); i++)
+        {
+          if(start_links[i] < POT_HIGH)
+            reachNode(node_offset_[ks] + i, start_cluster.nodes[i], goal,
+                      start_links[i], id);
+        }
+        if(direct < POT_HIGH)
+          reachNode(goal_id, goal, goal, direct, id);
+        continue;
+      }
+
+      int k = node_cluster_[id];
+      int i = id - node_offset_[k];
+      const Cluster& cluster = clusters_[k];
+      if(!cluster.paths_built)
+      {
+        buildPaths(costs, k);
+        stats_.paths_built++;
+      }
+      int count = cluster.nodes.size();
+      int cell = cluster.nodes[i];
+
+      for(int j = 0; j < count; j++)
+      {
+        float path_cost = cluster.paths[i * count + j];
+        if(j != i && path_cost < POT_HIGH)
+          reachNode(node_offset_[k] + j, cluster.nodes[j], goal,
+                    cost + path_cost, id);
+      }
+
+      for(unsigned int p = 0; p < cluster.partners[i].size(); p++)
+      {
+        int partner = cluster.partners[i][p];
+        int m = clusterOf(partner % nx_, partner / nx_);
+        int j = findNode(clusters_[m], partner);
+        if(j >= 0)
+          reachNode(node_offset_[m] + j, partner, goal,
+                    cost + stepCost(costs, cell, partner, false), id);
+      }
+
+      if(k == kg && goal_links[i] < POT_HIGH)
+        reachNode(goal_id, goal, goal, cost + goal_links[i], id);
+    }
+
+    if(!found)
+      return false;
+
+    // refine, searching the cells of the clusters the abstract path crosses
+    clearRegion();
+    addToRegion(costs, ks);
+    addToRegion(costs, kg);
+    for(int id = node_parent_[goal_id]; id != start_id; id = node_parent_[id])
+      addToRegion(costs, node_cluster_[id]);
+    stats_.refined_clusters = region_.size();
+    stats_.refined_expanded = searchCells(costs, start, goal);
+
+    if(reachedCost(goal) >= POT_HIGH)
+      return false;
+
+    for(int l = localIndex(goal % nx_, goal / nx_); l >= 0; l = cell_parent_[l])
+      path.push_back(cellOf(l));
+    std::reverse(path.begin(), path.end());
+    return true;
+  }
+
+} //end namespace global_planner
@@ -0,0 +1,310 @@
+#ifndef _CLUSTER_GRAPH_H_
+#define _CLUSTER_GRAPH_H_
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../GlobalPlanner/Algorithm/IndexedHeap.h"
+
+namespace NS_Planner
+{
+
+  /**
+   * @class HierarchicalStats
+   * @brief Counters of the last ClusterGraph::update() and findPath() calls
+   */
+  class HierarchicalStats
+  {
+  public:
+    HierarchicalStats()
+        : clusters_rebuilt(0), entrance_nodes(0), paths_built(0),
+          abstract_expanded(0), connect_expanded(0), refined_expanded(0),
+          refined_clusters(0)
+    {
+    }
+
+    unsigned long clusters_rebuilt; ///< Clusters whose entrances were recalculated
+    unsigned long entrance_nodes; ///< Nodes of the abstract graph
+    unsigned long paths_built; ///< Clusters whose paths between nodes were calculated by the abstract search
+    unsigned long abstract_expanded; ///< Nodes expanded by the abstract search
+    unsigned long connect_expanded; ///< Cells expanded to link the start and the goal to their clusters
+    unsigned long refined_expanded; ///< Cells expanded by the search along the abstract path
+    unsigned long refined_clusters; ///< Clusters the refining search was limited to
+  };
+
+  /**
+   * @class ClusterGraph
+   * @brief Abstract graph of the costmap for hierarchical path finding (HPA*)
+   *
+   * The map is split into square clusters. Where the cells along the border
+   * of two clusters are passable on both sides, an entrance links a node on
+   * each side, and the cost of the cheapest path inside a cluster between
+   * any two of its nodes is kept. A path is found on this graph first, then
+   * searched cell by cell inside the clusters it crosses only.
+   *
+   * Cells move to their 8 neighbors, a step costs the mean traversal cost of
+   * both cells times the step length. Only clusters with cells marked as
+   * changed in or next to them get new entrances, and the paths inside a
+   * cluster are calculated when the abstract search first reaches it.
+   */
+  class ClusterGraph
+  {
+  public:
+    ClusterGraph();
+
+    /**
+     * @brief Set the cost model of Expander, every cluster is rebuilt
+     */
+    void
+    setCosts(unsigned char lethal_cost, unsigned char neutral_cost,
+             float factor, bool unknown);
+
+    /**
+     * @brief Fit a nx x ny map, every cluster is rebuilt
+     */
+    void
+    setSize(int nx, int ny, int cluster_size);
+
+    int getSizeX() const
+    {
+      return nx_;
+    }
+
+    int getSizeY() const
+    {
+      return ny_;
+    }
+
+    /**
+     * @brief The cells in [x0, xn) x [y0, yn) may have changed
+     */
+    void
+    markChanged(int x0, int y0, int xn, int yn);
+
+    void
+    markAllChanged();
+
+    /**
+     * @brief Find the entrances of the clusters marked as changed in costs
+     */
+    void
+    update(unsigned char* costs);
+
+    /**
+     * @brief Find a path of cells from start to goal, update() must have been called with costs
+     */
+    bool
+    findPath(unsigned char* costs, int start, int goal,
+             std::vector< int >& path);
+
+    HierarchicalStats getStats()
+    {
+      return stats_;
+    }
+
+  private:
+    class Cluster
+    {
+    public:
+      Cluster()
+          : x0(0), y0(0), xn(0), yn(0), changed(true), paths_built(false)
+      {
+      }
+
+      int x0, y0, xn, yn; ///< Cells [x0, xn) x [y0, yn)
+      bool changed; ///< The entrances have to be found again
+      bool paths_built; ///< paths is up to date with the nodes
+      std::vector< int > nodes; ///< Cells of the entrance nodes
+      std::vector< std::vector< int > > partners; ///< Nodes of the neighbor clusters each node has an entrance to
+      std::vector< float > paths; ///< Path costs between the nodes, nodes x nodes, POT_HIGH if not connected inside the cluster
+    };
+
+    /**
+     * @brief Traversal cost of cell n as in Expander, lethal_cost_ if it can not be entered
+     */
+    inline float getCost(unsigned char* costs, int n)
+    {
+      float c = costs[n];
+      if(c < lethal_cost_ - 1 || (unknown_ && c == 255))
+      {
+        c = c * factor_ + neutral_cost_;
+        if(c >= lethal_cost_)
+          c = lethal_cost_ - 1;
+        return c;
+      }
+      return lethal_cost_;
+    }
+
+    inline bool isPassable(unsigned char* costs, int n)
+    {
+      return getCost(costs, n) < lethal_cost_;
+    }
+
+    inline float stepCost(unsigned char* costs, int a, int b, bool diagonal)
+    {
+      return (getCost(costs, a) + getCost(costs, b)) * (diagonal ? 0.5 * M_SQRT2 : 0.5);
+    }
+
+    inline int clusterOf(int x, int y)
+    {
+      return (y / cluster_size_) * cnx_ + x / cluster_size_;
+    }
+
+    /**
+     * @brief Lower bound of the path cost between two cells
+     */
+    inline float distance(int a, int b)
+    {
+      int dx = abs(a % nx_ - b % nx_), dy = abs(a / nx_ - b / nx_);
+      return neutral_cost_ * (dx > dy ? dx + (M_SQRT2 - 1) * dy : dy + (M_SQRT2 - 1) * dx);
+    }
+
+    /**
+     * @brief Cell search number of cell x, y, -1 outside the region
+     */
+    inline int localIndex(int x, int y)
+    {
+      int slot = region_slot_[clusterOf(x, y)];
+      if(slot < 0)
+        return -1;
+      return (slot * cluster_size_ + y % cluster_size_) * cluster_size_ + x % cluster_size_;
+    }
+
+    inline int cellOf(int l)
+    {
+      const Cluster& cluster = clusters_[region_[l / (cluster_size_ * cluster_size_)]];
+      int r = l % (cluster_size_ * cluster_size_);
+      return (cluster.y0 + r / cluster_size_) * nx_ + cluster.x0 + r % cluster_size_;
+    }
+
+    /**
+     * @brief Index of cell among the nodes of cluster, -1 if it is none
+     */
+    inline int findNode(const Cluster& cluster, int cell)
+    {
+      for(unsigned int i = 0; i < cluster.nodes.size(); i++)
+      {
+        if(cluster.nodes[i] == cell)
+          return i;
+      }
+      return -1;
+    }
+
+    /**
+     * @brief Find the entrance nodes of cluster k on all its sides
+     */
+    void
+    buildEntrances(unsigned char* costs, int k);
+
+    /**
+     * @brief Add the entrances along length cells from first in steps of step, to the cells across of them
+     */
+    void
+    addEntrances(unsigned char* costs, Cluster& cluster, int first, int step,
+                 int across, int length);
+
+    /**
+     * @brief Link cell to its partner across a cluster border, making it a node if it is none yet
+     */
+    void
+    addNode(Cluster& cluster, int cell, int partner);
+
+    /**
+     * @brief Calculate the path costs between the nodes of cluster k
+     */
+    void
+    buildPaths(unsigned char* costs, int k);
+
+    /**
+     * @brief Limit searchCells() to the clusters added after this
+     */
+    void
+    clearRegion();
+
+    /**
+     * @brief Add cluster k to the region, taking the traversal costs of its cells
+     */
+    void
+    addToRegion(unsigned char* costs, int k);
+
+    /**
+     * @brief Search the cells of the region from source, towards target or all of them if target is -1
+     *
+     * A search of all cells stops early once the cells flagged in
+     * cell_target_ are expanded, if targets_left_ tells how many there are.
+     * @return The number of cells expanded
+     */
+    unsigned long
+    searchCells(unsigned char* costs, int source, int target);
+
+    /**
+     * @brief Reach cell search number ml by a path of cost from l
+     */
+    inline void reachCell(int ml, int l, float cost, float key)
+    {
+      if(cell_marks_[ml] != cell_generation_)
+      {
+        cell_marks_[ml] = cell_generation_;
+        cell_cost_[ml] = cost;
+        cell_parent_[ml] = l;
+        cell_queue_.push(ml, key);
+      }
+      else if(cell_positions_[ml] >= 0 && cost < cell_cost_[ml])
+      {
+        cell_cost_[ml] = cost;
+        cell_parent_[ml] = l;
+        cell_queue_.decrease(ml, key);
+      }
+    }
+
+    /**
+     * @brief Path cost of cell n found by the last searchCells(), POT_HIGH if not reached
+     */
+    float
+    reachedCost(int n);
+
+    /**
+     * @brief Reach node id at cell by a path of cost from parent in the abstract search
+     */
+    void
+    reachNode(int id, int cell, int goal, float cost, int parent);
+
+    int nx_, ny_;
+    int cluster_size_, cnx_, cny_;
+    unsigned char lethal_cost_, neutral_cost_;
+    float factor_;
+    bool unknown_;
+
+    std::vector< Cluster > clusters_;
+    std::vector< int > changed_clusters_;
+    std::vector< int > node_offset_; /**< id of the first node of each cluster in the abstract search */
+    std::vector< int > node_cluster_; /**< cluster of each node id */
+
+    // abstract search, over node ids and the start and goal after them
+    IndexedHeap node_queue_;
+    std::vector< float > node_cost_;
+    std::vector< int > node_parent_;
+    std::vector< int > node_positions_;
+    std::vector< unsigned int > node_marks_;
+    unsigned int node_generation_;
+
+    // cell search, over the clusters of the region with cells numbered
+    // slot * cluster_size_^2 + row * cluster_size_ + column
+    IndexedHeap cell_queue_;
+    std::vector< int > region_; /**< clusters of the region in slot order */
+    std::vector< int > region_slot_; /**< slot of each cluster, -1 outside the region */
+    std::vector< float > cell_terrain_; /**< traversal cost of each cell of the region, lethal_cost_ past the map edge */
+    std::vector< char > cell_target_;
+    int targets_left_;
+    std::vector< float > cell_cost_;
+    std::vector< int > cell_parent_;
+    std::vector< int > cell_positions_;
+    std::vector< unsigned int > cell_marks_;
+    unsigned int cell_generation_;
+
+    HierarchicalStats stats_;
+  };
+
+} //end namespace global_planner
+#endif
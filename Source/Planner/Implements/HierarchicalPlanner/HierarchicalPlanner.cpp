@@ -0,0 +1,172 @@
+#include "HierarchicalPlanner.h"
+
+#include <Parameter/Parameter.h>
+#include <Console/Console.h>
+
+namespace NS_Planner
+{
+
+  HierarchicalPlanner::HierarchicalPlanner()
+      : initialized_(false), cluster_size_(64), orientation_filter_(NULL),
+        planned_version_(0)
+  {
+  }
+
+  HierarchicalPlanner::~HierarchicalPlanner()
+  {
+    delete orientation_filter_;
+  }
+
+  void HierarchicalPlanner::onInitialize()
+  {
+    if(initialized_)
+    {
+      printf("onInitialize has been called before\n");
+      return;
+    }
+
+    NS_NaviCommon::Parameter parameter;
+    parameter.loadConfigurationFile("hierarchical_planner.xml");
+
+    cluster_size_ = parameter.getParameter("cluster_size", 64);
+
+    bool allow_unknown = parameter.getParameter("allow_unknown", 1) == 1;
+    int lethal_cost = parameter.getParameter("lethal_cost", 253);
+    int neutral_cost = parameter.getParameter("neutral_cost", 50);
+    double cost_factor = parameter.getParameter("cost_factor", 3.0f);
+    graph_.setCosts(lethal_cost, neutral_cost, cost_factor, allow_unknown);
+
+    orientation_filter_ = new OrientationFilter();
+    orientation_filter_->setMode(parameter.getParameter("orientation_mode", 1));
+
+    initialized_ = true;
+  }
+
+  void HierarchicalPlanner::markChanges(unsigned long version)
+  {
+    int nx = planning_costmap_.getSizeInCellsX(),
+        ny = planning_costmap_.getSizeInCellsY();
+    std::vector< NS_CostMap::DirtyRect > changes;
+
+    if(nx != graph_.getSizeX() || ny != graph_.getSizeY())
+    {
+      graph_.setSize(nx, ny, cluster_size_);
+    }
+    else if(planned_version_ == 0 || !costmap->getLayeredCostmap()->getChangesSince(
+        planned_version_, changes))
+    {
+      graph_.markAllChanged();
+    }
+    else
+    {
+      for(unsigned int i = 0; i < changes.size(); i++)
+      {
+        int x0, y0, xn, yn;
+        planning_costmap_.worldToMapEnforceBounds(changes[i].min_x,
+                                                  changes[i].min_y, x0, y0);
+        planning_costmap_.worldToMapEnforceBounds(changes[i].max_x,
+                                                  changes[i].max_y, xn, yn);
+        graph_.markChanged(x0, y0, xn + 1, yn + 1);
+      }
+    }
+
+    planned_version_ = version;
+  }
+
+  bool HierarchicalPlanner::makePlan(const NS_DataType::PoseStamped& start,
+                                     const NS_DataType::PoseStamped& goal,
+                                     std::vector< NS_DataType::PoseStamped >& plan)
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+
+    if(!initialized_)
+    {
+      printf(
+          "This planner has not been initialized yet, but it is being used, please call initialize() before use\n");
+      return false;
+    }
+
+    plan.clear();
+
+    NS_CostMap::CostmapSnapshotPtr snapshot = costmap->getSnapshot();
+    if(snapshot->getVersion() == 0)
+    {
+      printf("The costmap has not been published yet, unable to plan.\n");
+      return false;
+    }
+    planning_costmap_ = snapshot->getCostmap();
+
+    unsigned int start_x, start_y, goal_x, goal_y;
+    if(!planning_costmap_.worldToMap(start.pose.position.x,
+                                     start.pose.position.y, start_x, start_y))
+    {
+      printf(
+          "The robot's start position is off the global costmap. Planning will always fail, are you sure the robot has been properly localized?\n");
+      return false;
+    }
+    if(!planning_costmap_.worldToMap(goal.pose.position.x, goal.pose.position.y,
+                                     goal_x, goal_y))
+    {
+      printf(
+          "The goal sent to the global planner is off the global costmap. Planning will always fail to this goal.\n");
+      return false;
+    }
+
+    markChanges(snapshot->getVersion());
+
+    unsigned char* costs = planning_costmap_.getCharMap();
+    graph_.update(costs);
+
+    // the robot's cell is free for the search only, the entrances are found
+    // on the costs of the snapshot
+    int nx = planning_costmap_.getSizeInCellsX();
+    int start_cell = start_y * nx + start_x;
+    if(costs[start_cell] != NS_CostMap::FREE_SPACE)
+    {
+      planning_costmap_.setCost(start_x, start_y, NS_CostMap::FREE_SPACE);
+      // paths the search builds in the robot's cluster take the cleared cell
+      graph_.markChanged(start_x, start_y, start_x + 1, start_y + 1);
+    }
+
+    std::vector< int > cells;
+    bool found = graph_.findPath(costs, start_cell, goal_y * nx + goal_x,
+                                 cells);
+
+    HierarchicalStats stats = graph_.getStats();
+    NS_NaviCommon::console.debug(
+        "Hierarchical plan: %lu clusters rebuilt, %lu paths built, %lu of %lu nodes expanded, %lu cells refined in %lu clusters, %lu to connect",
+        stats.clusters_rebuilt, stats.paths_built, stats.abstract_expanded,
+        stats.entrance_nodes, stats.refined_expanded, stats.refined_clusters,
+        stats.connect_expanded);
+
+    if(!found)
+    {
+      printf("Failed to get a plan.\n");
+      return false;
+    }
+
+    NS_NaviCommon::Time plan_time = NS_NaviCommon::Time::now();
+    for(unsigned int i = 0; i + 1 < cells.size(); i++)
+    {
+      NS_DataType::PoseStamped pose;
+      pose.header.stamp = plan_time;
+      planning_costmap_.mapToWorld(cells[i] % nx, cells[i] / nx,
+                                   pose.pose.position.x, pose.pose.position.y);
+      pose.pose.position.z = 0.0;
+      pose.pose.orientation.x = 0.0;
+      pose.pose.orientation.y = 0.0;
+      pose.pose.orientation.z = 0.0;
+      pose.pose.orientation.w = 1.0;
+      plan.push_back(pose);
+    }
+
+    NS_DataType::PoseStamped goal_copy = goal;
+    goal_copy.header.stamp = plan_time;
+    plan.push_back(goal_copy);
+
+    orientation_filter_->processPath(start, plan);
+
+    return true;
+  }
+
+} //end namespace global_planner
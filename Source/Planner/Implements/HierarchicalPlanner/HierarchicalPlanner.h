@@ -0,0 +1,62 @@
+#ifndef _HIERARCHICAL_PLANNER_H_
+#define _HIERARCHICAL_PLANNER_H_
+
+#include "../../Base/GlobalPlannerBase.h"
+#include "../GlobalPlanner/Algorithm/OrientationFilter.h"
+#include "ClusterGraph.h"
+
+#include <boost/thread/mutex.hpp>
+
+namespace NS_Planner
+{
+
+  /**
+   * @class HierarchicalPlanner
+   * @brief Global planner that plans on a graph of map clusters first (HPA*)
+   *
+   * The cluster graph is kept between plans and only the clusters the
+   * costmap changed in are rebuilt, so a long plan costs a search of the
+   * abstract graph and of the cells of the clusters along its path.
+   */
+  class HierarchicalPlanner: public GlobalPlannerBase
+  {
+  public:
+    HierarchicalPlanner();
+    virtual
+    ~HierarchicalPlanner();
+
+    void
+    onInitialize();
+
+    bool
+    makePlan(const NS_DataType::PoseStamped& start,
+             const NS_DataType::PoseStamped& goal,
+             std::vector< NS_DataType::PoseStamped >& plan);
+
+    /**
+     * @brief Counters of the last plan
+     */
+    HierarchicalStats getStats()
+    {
+      return graph_.getStats();
+    }
+
+  private:
+    /**
+     * @brief Mark the cells changed since the last plan in the cluster graph
+     */
+    void
+    markChanges(unsigned long version);
+
+    bool initialized_;
+    boost::mutex mutex_;
+
+    ClusterGraph graph_;
+    int cluster_size_; ///< Side of a cluster in cells
+    OrientationFilter* orientation_filter_;
+    NS_CostMap::Costmap2D planning_costmap_; ///< Private copy of the costmap snapshot
+    unsigned long planned_version_; ///< Snapshot version the graph was last updated to, 0 before the first plan
+  };
+
+} //end namespace global_planner
+#endif
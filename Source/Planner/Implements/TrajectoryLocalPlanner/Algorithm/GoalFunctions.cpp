@@ -2,8 +2,7 @@
 #include "GoalFunctions.h"
 #include <math.h>
 
-#include <Service/ServiceType/ServiceTransform.h>
-#include <Service/Client.h>
+#include "../../../../CostMap/Utils/TransformCache.h"
 
 namespace NS_Planner
 {
@@ -67,10 +66,6 @@ namespace NS_Planner
     const NS_DataType::PoseStamped& plan_pose = global_plan[0];
     if(1)
     {
-      NS_Service::Client< NS_ServiceType::ServiceTransform > map_tf_cli(
-          "ODOM_MAP_TF");
-      NS_ServiceType::ServiceTransform map_transform;
-
       // get plan_to_global_transform from plan frame to global_frame
       // odom->map
       NS_Transform::StampedTransform plan_to_global_transform;
@@ -84,13 +79,12 @@ namespace NS_Planner
        plan_pose.header.frame_id, plan_to_global_transform);
        */
       //TODO: may be not need ,map->odom
-      if(map_tf_cli.call(map_transform) == false)
+      if(!NS_CostMap::TransformCache::getInstance().getMapTransform(
+          plan_to_global_tf))
       {
         printf("Get map transform failure!\n");
         return false;
       }
-      NS_Transform::transformMsgToTF(map_transform.transform,
-                                     plan_to_global_tf);
       plan_to_global_transform.setData(plan_to_global_tf);
 
       //let's get the pose of the robot in the frame of the plan
@@ -100,17 +94,13 @@ namespace NS_Planner
       /*
        NS_Transform.transformPose(plan_pose.header.frame_id, global_pose, robot_pose);
        */
-      NS_Service::Client< NS_ServiceType::ServiceTransform > odom_tf_cli(
-          "BASE_ODOM_TF");
-      NS_ServiceType::ServiceTransform odom_transform;
       NS_Transform::Transform global_to_base_tf;
-      if(odom_tf_cli.call(odom_transform) == false)
+      if(!NS_CostMap::TransformCache::getInstance().getOdomTransform(
+          global_to_base_tf))
       {
         printf("Get odometry transform failure!\n");
         return false;
       }
-      NS_Transform::transformMsgToTF(odom_transform.transform,
-                                     global_to_base_tf);
       robot_pose.setData(plan_to_global_tf * global_to_base_tf);
 
       //we'll discard points on the plan that are outside the local costmap
@@ -186,19 +176,14 @@ namespace NS_Planner
        plan_goal_pose.header.frame_id, plan_goal_pose.header.stamp,
        plan_goal_pose.header.frame_id, transform);
        */
-      NS_Service::Client< NS_ServiceType::ServiceTransform > map_tf_cli(
-          "ODOM_MAP_TF");
-      NS_ServiceType::ServiceTransform map_transform;
-      if(map_tf_cli.call(map_transform) == false)
+      NS_Transform::Transform transform;
+      if(!NS_CostMap::TransformCache::getInstance().getMapTransform(transform))
       {
         printf("Get map transform failure!\n");
         return false;
       }
 
-      NS_Transform::Transform transform;
-
       //poseStampedMsgToTF(plan_goal_pose, goal_pose);
-      NS_Transform::transformMsgToTF(map_transform.transform, transform);
 
       goal_pose.setData(transform * goal_pose);
     }
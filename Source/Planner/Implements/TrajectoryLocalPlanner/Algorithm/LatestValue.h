@@ -0,0 +1,79 @@
+#ifndef _PLANNER_LATEST_VALUE_H_
+#define _PLANNER_LATEST_VALUE_H_
+
+namespace NS_Planner
+{
+  /**
+   * @class LatestValue
+   * @brief Hands the latest value from one writer thread to one reader thread without locks
+   *
+   * A triple buffer: the writer fills its own slot and swaps it with the
+   * shared middle slot, the reader swaps its slot with the middle one when
+   * a fresh value is there. Neither side ever touches a slot the other is
+   * using, so values with strings or vectors are copied safely.
+   */
+  template< typename T >
+  class LatestValue
+  {
+  public:
+    LatestValue()
+        : write_slot_(0), middle_slot_(1), read_slot_(2), has_value_(false)
+    {
+    }
+
+    /**
+     * @brief Publish value, only called from the writer thread
+     */
+    void write(const T& value)
+    {
+      slots_[write_slot_] = value;
+      write_slot_ = exchange(write_slot_ | FRESH) & SLOT_MASK;
+    }
+
+    /**
+     * @brief Take the newest published value, only called from the reader thread
+     * @return false if nothing was ever written
+     */
+    bool read(T& value)
+    {
+      if(__sync_fetch_and_or(&middle_slot_, 0) & FRESH)
+      {
+        read_slot_ = exchange(read_slot_) & SLOT_MASK;
+        has_value_ = true;
+      }
+
+      if(!has_value_)
+        return false;
+
+      value = slots_[read_slot_];
+      return true;
+    }
+
+  private:
+    /**
+     * @brief Swap slot into the middle, a full barrier so the slot contents travel with it
+     */
+    int exchange(int slot)
+    {
+      int old_slot;
+      do
+      {
+        old_slot = __sync_fetch_and_or(&middle_slot_, 0);
+      } while(__sync_val_compare_and_swap(&middle_slot_, old_slot, slot) != old_slot);
+      return old_slot;
+    }
+
+    enum
+    {
+      SLOT_MASK = 3, FRESH = 4
+    };
+
+    T slots_[3];
+    int write_slot_; ///< Owned by the writer
+    volatile int middle_slot_; ///< Shared, FRESH is set when the writer swapped a new value in
+    int read_slot_; ///< Owned by the reader
+    bool has_value_;
+  };
+}
+
+#endif  // _PLANNER_LATEST_VALUE_H_
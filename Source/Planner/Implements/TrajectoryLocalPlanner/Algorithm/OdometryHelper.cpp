@@ -1,55 +1,89 @@
 #include <Transform/DataTypes.h>
 #include <DataSet/DataType/Odometry.h>
 #include "OdometryHelper.h"
+#include <boost/bind.hpp>
 
 namespace NS_Planner
 {
 
   OdometryHelper::OdometryHelper()
   {
+    odom_valid_ = false;
+    max_odom_age_ = 0.5;
+
     odom_cli = new NS_Service::Client< NS_ServiceType::ServiceOdometry >(
         "BASE_ODOM");
+    odom_sub = new NS_DataSet::Subscriber< NS_DataType::Odometry >(
+        "BASE_ODOM", boost::bind(&OdometryHelper::odomCallback, this, _1));
   }
 
   OdometryHelper::~OdometryHelper()
   {
+    delete odom_sub;
     delete odom_cli;
   }
 
-  void OdometryHelper::getRobotVel(
-      NS_Transform::Stamped< NS_Transform::Pose >& robot_vel)
+  void OdometryHelper::odomCallback(NS_DataType::Odometry& odom)
   {
-    // Set current velocities from odometry
-    NS_DataType::Twist global_vel;
+    OdometrySample sample;
+    sample.odom = odom;
+    sample.stamp = NS_NaviCommon::Time::now();
+    latest_odom.write(sample);
+  }
 
-    NS_ServiceType::ServiceOdometry odom_rep;
+  bool OdometryHelper::updateOdom()
+  {
+    NS_NaviCommon::Time now = NS_NaviCommon::Time::now();
+
+    OdometrySample sample;
+    if(latest_odom.read(sample) && (now - sample.stamp).toSec() <= max_odom_age_)
+    {
+      base_odom_ = sample.odom;
+      odom_stamp_ = sample.stamp;
+      odom_valid_ = true;
+      return true;
+    }
 
+    // nothing fresh was published, ask for it
+    NS_ServiceType::ServiceOdometry odom_rep;
     if(odom_cli->call(odom_rep) && odom_rep.result)
     {
       base_odom_ = odom_rep.odom;
+      odom_stamp_ = now;
+      odom_valid_ = true;
+      return true;
+    }
+
+    return false;
+  }
 
-      global_vel.linear.x = base_odom_.twist.linear.x;
-      global_vel.linear.y = base_odom_.twist.linear.y;
-      global_vel.angular.z = base_odom_.twist.angular.z;
+  void OdometryHelper::getRobotVel(
+      NS_Transform::Stamped< NS_Transform::Pose >& robot_vel)
+  {
+    if(!odom_valid_ && !updateOdom())
+      return;
 
-      robot_vel.setData(
-          NS_Transform::Transform(
-              NS_Transform::createQuaternionFromYaw(global_vel.angular.z),
-              NS_Transform::Vector3(global_vel.linear.x, global_vel.linear.y,
-                                    0)));
-      robot_vel.stamp_ = NS_NaviCommon::Time();
-    }
+    // Set current velocities from odometry
+    NS_DataType::Twist global_vel;
+
+    global_vel.linear.x = base_odom_.twist.linear.x;
+    global_vel.linear.y = base_odom_.twist.linear.y;
+    global_vel.angular.z = base_odom_.twist.angular.z;
+
+    robot_vel.setData(
+        NS_Transform::Transform(
+            NS_Transform::createQuaternionFromYaw(global_vel.angular.z),
+            NS_Transform::Vector3(global_vel.linear.x, global_vel.linear.y,
+                                  0)));
+    robot_vel.stamp_ = NS_NaviCommon::Time();
   }
 
   void OdometryHelper::getOdom(NS_DataType::Odometry& base_odom)
   {
-    NS_ServiceType::ServiceOdometry odom_rep;
+    if(!odom_valid_ && !updateOdom())
+      return;
 
-    if(odom_cli->call(odom_rep) && odom_rep.result)
-    {
-      base_odom_ = odom_rep.odom;
-      base_odom = base_odom_;
-    }
+    base_odom = base_odom_;
   }
 
 } /* namespace base_local_planner */
@@ -8,6 +8,9 @@
 #include <Transform/DataTypes.h>
 #include <Service/ServiceType/ServiceOdometry.h>
 #include <Service/Client.h>
+#include <DataSet/Subscriber.h>
+#include <Time/Time.h>
+#include "LatestValue.h"
 
 namespace NS_Planner
 {
@@ -24,8 +27,18 @@ namespace NS_Planner
     ~OdometryHelper();
 
     /**
-     * @brief  Callback for receiving odometry data
-     * @param msg An Odometry message
+     * @brief Take the newest odometry as the sample of this control cycle
+     *
+     * getOdom() and getRobotVel() return this sample until the next call, so
+     * one cycle never mixes two readings. Falls back to the BASE_ODOM service
+     * when no fresh odometry was published.
+     * @return false if no odometry is available
+     */
+    bool
+    updateOdom();
+
+    /**
+     * @brief Odometry of the current cycle, latched by updateOdom()
      */
     void
     getOdom(NS_DataType::Odometry& base_odom);
@@ -33,8 +46,34 @@ namespace NS_Planner
     void
     getRobotVel(NS_Transform::Stamped< NS_Transform::Pose >& robot_vel);
 
+    /**
+     * @brief Time the current odometry sample was received
+     */
+    NS_NaviCommon::Time
+    getOdomStamp() const
+    {
+      return odom_stamp_;
+    }
+
   private:
-    NS_DataType::Odometry base_odom_;
+    struct OdometrySample
+    {
+      NS_DataType::Odometry odom;
+      NS_NaviCommon::Time stamp; ///< Receive time
+    };
+
+    void
+    odomCallback(NS_DataType::Odometry& odom);
+
+    NS_DataType::Odometry base_odom_; ///< Sample of the current cycle
+    NS_NaviCommon::Time odom_stamp_;
+    bool odom_valid_;
+
+    double max_odom_age_; ///< Seconds after which published odometry is not used any more
+
+    LatestValue< OdometrySample > latest_odom; ///< Written by the subscriber, read by the control thread
+
+    NS_DataSet::Subscriber< NS_DataType::Odometry >* odom_sub;
     NS_Service::Client< NS_ServiceType::ServiceOdometry >* odom_cli;
 
   };
@@ -48,7 +48,7 @@ namespace NS_Planner
       rotating_to_goal_ = false;
 
       //initialize the copy of the costmap the controller will use
-      costmap_ = costmap->getCostmap();
+      costmap_ = &costmap_copy;
 
       /*
        global_frame_ = costmap_ros_->getGlobalFrameID();
@@ -345,6 +345,11 @@ namespace NS_Planner
       return false;
     }
 
+    updateCostmapCopy();
+
+    // one odometry sample for the whole cycle
+    odom_helper_->updateOdom();
+
     std::vector< NS_DataType::PoseStamped > local_plan;
     NS_Transform::Stamped< NS_Transform::Pose > global_pose;
     if(!costmap->getRobotPose(global_pose))